@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <exceptions.hpp>
+#include <map_builder.hpp>
+#include <utils.hpp>
+
+/**
+ * @brief Map generation benchmark
+ *
+ * Time the generation of random connected maps of 10^3 to 10^6 nodes (by default) for
+ * the directed and symmetric directed graph types.
+ * Usage: bench_map_generation [max_nb_nodes] [nb_threads] [nb_time_steps]
+ * The durations have few time steps by default so that the topology dominates the
+ * generation time and the largest maps fit in memory.
+ */
+int main(int argc, char **argv) {
+    unsigned max_nb_nodes = (argc > 1) ? atoi(argv[1]) : 1000000;
+    unsigned nb_threads = (argc > 2) ? atoi(argv[2]) : 0;
+    unsigned nb_time_steps = (argc > 3) ? atoi(argv[3]) : 1;
+    std::cout << "graph_type nb_nodes nb_edges time_ms ns_per_edge" << std::endl;
+    for(unsigned nb_nodes=1000; nb_nodes<=max_nb_nodes; nb_nodes*=10) {
+        for(unsigned graph_type=0; graph_type<2; ++graph_type) {
+            map_builder mb(
+                0, // sampler_selector
+                nb_time_steps,
+                10, // time_steps_width
+                nb_nodes,
+                8, // min_nb_edges_per_node
+                0, // nb_links
+                0, // nb_nodes_per_link
+                0., // duration_min
+                100., // duration_max
+                1., // lip
+                false, // procedural_durations
+                "n0", // initial_location
+                "n1", // terminal_location
+                "", // input_duration_matrix
+                ";", // csv_sep
+                nb_threads,
+                42 // seed
+            );
+            map_graph g;
+            auto t_start = std::chrono::steady_clock::now();
+            if(graph_type == 0) {
+                mb.build_connected_directed_duration_matrix(g);
+            } else {
+                mb.build_connected_symmetric_directed_duration_matrix(g);
+            }
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+            std::cout << graph_type << " " << nb_nodes << " " << g.get_nb_edges() << " ";
+            std::cout << 1e3 * elapsed << " " << 1e9 * elapsed / g.get_nb_edges() << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <agent.hpp>
+#include <environment.hpp>
+#include <exceptions.hpp>
+#include <map_builder.hpp>
+#include <mcts_policy.hpp>
+#include <utils.hpp>
+
+/**
+ * @brief Tree depth
+ *
+ * @return Return the maximum number of decision nodes on a path from the root of a tree.
+ */
+unsigned tree_depth(const mcts_tree &t, unsigned d = 0) {
+    unsigned depth = 0;
+    for(unsigned c = t.d_first_child[d]; c != NO_NODE; c = t.c_sibling[c]) {
+        for(unsigned e = t.c_first_child[c]; e != NO_NODE; e = t.d_sibling[e]) {
+            depth = std::max(depth,tree_depth(t,e));
+        }
+    }
+    return depth + 1;
+}
+
+unsigned tree_depth(const shared_mcts_tree &t, unsigned d = 0) {
+    unsigned depth = 0;
+    for(unsigned c = t.get_first_child(d); c != NO_NODE; c = t.get_next_sibling(c)) {
+        for(unsigned e = t.c_first_child[c]; e != NO_NODE; e = t.d_sibling[e]) {
+            depth = std::max(depth,tree_depth(t,e));
+        }
+    }
+    return depth + 1;
+}
+
+/**
+ * @brief Parallel MCTS benchmark
+ *
+ * Compare root parallelism, each search thread building its own tree, to tree parallelism,
+ * the search threads sharing a single tree, with UCT on a random map.
+ * Each thread spends the whole budget, hence both modes run the same number of iterations;
+ * the nodes, memory and depth are the ones of every tree of the search, the memory being
+ * the bytes allocated by the trees, see mcts_tree::get_nb_bytes and
+ * shared_mcts_tree::get_nb_bytes.
+ * Usage: bench_mcts_parallel [nb_nodes] [budget] [max_nb_threads]
+ */
+int main(int argc, char **argv) {
+    unsigned nb_nodes = (argc > 1) ? atoi(argv[1]) : 2000;
+    unsigned budget = (argc > 2) ? atoi(argv[2]) : 20000;
+    unsigned max_nb_threads = (argc > 3) ? atoi(argv[3]) : get_nb_threads(0);
+    map_builder mb(
+        3, // sampler_selector
+        100, // nb_time_steps
+        10, // time_steps_width
+        nb_nodes,
+        4, // min_nb_edges_per_node
+        0, // nb_links
+        0, // nb_nodes_per_link
+        0., // duration_min
+        100., // duration_max
+        1., // lip
+        false, // procedural_durations
+        "n0", // initial_location
+        "n1", // terminal_location
+        "", // input_duration_matrix
+        ";", // csv_sep
+        0, // nb_threads
+        42 // seed
+    );
+    std::unique_ptr<map_graph> g(new map_graph());
+    mb.build_connected_symmetric_directed_duration_matrix(*g);
+    environment en(1000., 0., -10000., g);
+    unsigned initial_id = 0;
+    en.graph->find_node_id("n0",initial_id);
+    state s(0.,&en.graph->nodes_vector[initial_id]);
+    std::cout << "mode nb_threads time_ms iterations_per_s nb_cnodes tree_mb depth" << std::endl;
+    for(unsigned nb_threads=1; nb_threads<=max_nb_threads; nb_threads*=2) {
+        for(unsigned mode=0; mode<2; ++mode) {
+            srand(1);
+            mcts_policy po(
+                &en,
+                true, // is_model_dynamic
+                1., // discount_factor
+                .707, // uct_parameter
+                budget,
+                100, // horizon
+                1, // nb_rollouts
+                1, // mcts_strategy_switch
+                false, // reuse_tree
+                nb_threads,
+                mode == 1, // tree_parallel
+                1., // virtual_loss
+                0, // time_limit
+                0, // calls_limit
+                0., // time_quantum
+                0., // widening_coefficient
+                .5, // widening_exponent
+                false, // share_transpositions
+                0. // tree_memory_limit
+            );
+            auto t_start = std::chrono::steady_clock::now();
+            po.apply(s);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+            size_t nb_cnodes = 0;
+            size_t bytes = 0;
+            unsigned depth = 0;
+            if(mode == 0) {
+                nb_cnodes += po.tree.get_nb_cnodes();
+                bytes += po.tree.get_nb_bytes();
+                depth = tree_depth(po.tree);
+                for(auto &w : po.workers) {
+                    nb_cnodes += w->tree.get_nb_cnodes();
+                    bytes += w->tree.get_nb_bytes();
+                    depth = std::max(depth,tree_depth(w->tree));
+                }
+            } else {
+                nb_cnodes = po.shared_tree->get_nb_cnodes();
+                bytes = po.shared_tree->get_nb_bytes();
+                depth = tree_depth(*po.shared_tree);
+            }
+            std::cout << ((mode == 0) ? "root" : "tree") << " " << nb_threads << " ";
+            std::cout << 1e3 * elapsed << " " << nb_threads * budget / elapsed << " ";
+            std::cout << nb_cnodes << " " << bytes / 1e6 << " " << depth << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <agent.hpp>
+#include <environment.hpp>
+#include <exceptions.hpp>
+#include <map_builder.hpp>
+#include <random_policy.hpp>
+#include <utils.hpp>
+
+/**
+ * @brief Reference rollout
+ *
+ * Rollout through the state-level interface, as sampled before the rollout kernel: a
+ * transition, a default policy application and a power of the discount factor per step.
+ * Template method.
+ * @return Return the discounted return of the rollout.
+ */
+template <class G>
+double reference_rollout(
+    const environment &en,
+    random_policy &default_policy,
+    state s,
+    action a,
+    double discount_factor,
+    unsigned horizon,
+    G &generator,
+    unsigned &nb_steps)
+{
+    double total_return = 0.;
+    for(unsigned t=0; t<horizon; ++t) {
+        state s_p;
+        double r = 0.;
+        en.transition(s,s.t,a,r,s_p);
+        ++nb_steps;
+        total_return += pow(discount_factor,(double)t) * r;
+        if(en.is_state_terminal(s_p)) {
+            break;
+        }
+        s = s_p;
+        a = default_policy.apply(s,generator);
+    }
+    return total_return;
+}
+
+/**
+ * @brief Rollout benchmark
+ *
+ * Count the rollout steps per second of the random default policy on a random map, from
+ * random initial nodes, for the reference state-level rollout, for the rollout kernel
+ * of the environment with the counter-based and the xoshiro generators, and for batches of
+ * rollouts from each initial node, which are not faster per step than the kernel.
+ * Usage: bench_rollout [nb_nodes] [nb_rollouts] [horizon] [batch_size]
+ */
+int main(int argc, char **argv) {
+    unsigned nb_nodes = (argc > 1) ? atoi(argv[1]) : 2000;
+    unsigned nb_rollouts = (argc > 2) ? atoi(argv[2]) : 100000;
+    unsigned horizon = (argc > 3) ? atoi(argv[3]) : 100;
+    unsigned batch_size = (argc > 4) ? atoi(argv[4]) : ROLLOUT_LANES;
+    std::vector<double> returns(batch_size);
+    map_builder mb(
+        3, // sampler_selector
+        100, // nb_time_steps
+        10, // time_steps_width
+        nb_nodes,
+        4, // min_nb_edges_per_node
+        0, // nb_links
+        0, // nb_nodes_per_link
+        0., // duration_min
+        100., // duration_max
+        1., // lip
+        false, // procedural_durations
+        "n0", // initial_location
+        "n1", // terminal_location
+        "", // input_duration_matrix
+        ";", // csv_sep
+        0, // nb_threads
+        42 // seed
+    );
+    std::unique_ptr<map_graph> g(new map_graph());
+    mb.build_connected_symmetric_directed_duration_matrix(*g);
+    environment en(1000., 0., -10000., g);
+    random_policy default_policy;
+    const double discount_factor = .99;
+    std::cout << "rollout nb_steps time_ms steps_per_s mean_return" << std::endl;
+    for(unsigned mode=0; mode<4; ++mode) {
+        counter_rng crng(1,0);
+        xoshiro_rng xrng(1,0);
+        counter_rng starts(2,0);
+        unsigned nb_steps = 0;
+        double sum = 0.;
+        auto t_start = std::chrono::steady_clock::now();
+        unsigned nb_starts = (mode == 3) ? nb_rollouts / batch_size : nb_rollouts;
+        for(unsigned i=0; i<nb_starts; ++i) {
+            unsigned nd = uniform_integer(starts,0,en.graph->get_nb_nodes()-1);
+            unsigned nb_edges = en.graph->get_nb_edges(nd);
+            if(en.graph->nodes_vector[nd].is_goal || nb_edges == 0) {
+                continue;
+            }
+            unsigned k = uniform_integer(starts,0,nb_edges-1);
+            if(mode == 0) {
+                state s(0.,&en.graph->nodes_vector[nd]);
+                sum += reference_rollout(en,default_policy,s,action(k),discount_factor,horizon,crng,nb_steps);
+            } else if(mode == 1) {
+                sum += en.rollout(nd,0.,k,true,0.,discount_factor,horizon,crng,nb_steps);
+            } else if(mode == 2) {
+                sum += en.rollout(nd,0.,k,true,0.,discount_factor,horizon,xrng,nb_steps);
+            } else {
+                en.batch_rollout(nd,0.,k,true,0.,discount_factor,horizon,xrng,batch_size,returns.data(),nb_steps);
+                for(double q : returns) {
+                    sum += q;
+                }
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        const char * names[] = {"reference", "kernel_counter", "kernel_xoshiro", "batch_xoshiro"};
+        std::cout << names[mode] << " " << nb_steps << " " << 1e3 * elapsed << " ";
+        std::cout << nb_steps / elapsed << " " << sum / (nb_starts * ((mode == 3) ? batch_size : 1)) << std::endl;
+    }
+    return 0;
+}
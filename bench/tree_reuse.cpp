@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <agent.hpp>
+#include <environment.hpp>
+#include <exceptions.hpp>
+#include <map_builder.hpp>
+#include <mcts_policy.hpp>
+#include <tmp_mcts_policy.hpp>
+#include <utils.hpp>
+
+/**
+ * @brief Root visits
+ *
+ * @return Return the number of visits of the children of the root of a tree, 0 if it is
+ * empty.
+ */
+unsigned root_visits(const mcts_tree &t) {
+    unsigned nb_visits = 0;
+    if(t.get_nb_dnodes() > 0) {
+        for(unsigned c = t.d_first_child[0]; c != NO_NODE; c = t.c_sibling[c]) {
+            nb_visits += t.get_nb_visits(c);
+        }
+    }
+    return nb_visits;
+}
+
+/**
+ * @brief Run episode
+ *
+ * Run an episode with a policy reusing its tree and check at each decision that the subtree
+ * kept by the previous step is the root of the search, ie that the visits of the root's
+ * children are the kept ones plus one per iteration.
+ * The observed times are slightly off the ones of the model, hence with time buckets the
+ * observed successor state is merged into a node of another time.
+ * Template method.
+ * @param {unsigned &} nb_reused; number of decisions reusing a kept subtree, incremented
+ * @return Return the number of decisions whose kept subtree was dropped.
+ */
+template <class P>
+unsigned run_episode(const environment &en, P &po, state s, unsigned &nb_reused) {
+    unsigned nb_dropped = 0;
+    for(unsigned k=0; k<50 && !en.is_state_terminal(s); ++k) {
+        unsigned kept = root_visits(po.tree);
+        action a = po.apply(s);
+        if(root_visits(po.tree) != kept + po.nb_iterations) {
+            ++nb_dropped;
+        } else if(kept > 0) {
+            ++nb_reused;
+        }
+        state s_p;
+        double r = 0.;
+        en.transition(s,s.t,a,r,s_p);
+        s_p.t += 1e-3; // observed time slightly off the predicted one, as measured in a real environment
+        po.step(a,s_p);
+        s = s_p;
+    }
+    return nb_dropped;
+}
+
+/**
+ * @brief Tree reuse check
+ *
+ * Run UCT and TMP-UCT episodes reusing the tree on a random map, from each of the first
+ * nodes of the map, with exact times, time buckets and shared transpositions, and check
+ * that the subtree of the observed successor state is kept as the root of the next search,
+ * with its visit counts.
+ * Usage: bench_tree_reuse [nb_nodes] [budget] [nb_episodes]
+ * @return Return 1 if a kept subtree was dropped, else 0.
+ */
+int main(int argc, char **argv) {
+    unsigned nb_nodes = (argc > 1) ? atoi(argv[1]) : 200;
+    unsigned budget = (argc > 2) ? atoi(argv[2]) : 2000;
+    unsigned nb_episodes = (argc > 3) ? atoi(argv[3]) : 20;
+    map_builder mb(
+        3, // sampler_selector
+        100, // nb_time_steps
+        10, // time_steps_width
+        nb_nodes,
+        4, // min_nb_edges_per_node
+        0, // nb_links
+        0, // nb_nodes_per_link
+        0., // duration_min
+        100., // duration_max
+        1., // lip
+        false, // procedural_durations
+        "n0", // initial_location
+        "n1", // terminal_location
+        "", // input_duration_matrix
+        ";", // csv_sep
+        0, // nb_threads
+        42 // seed
+    );
+    std::unique_ptr<map_graph> g(new map_graph());
+    mb.build_connected_symmetric_directed_duration_matrix(*g);
+    environment en(1000., 0., -10000., g);
+    unsigned nb_failures = 0;
+    std::cout << "policy time_quantum share_transpositions nb_reused nb_dropped" << std::endl;
+    for(double time_quantum : {0., 20.}) {
+        for(bool share_transpositions : {false, true}) {
+            for(unsigned mode=0; mode<2; ++mode) {
+                unsigned nb_reused = 0;
+                unsigned nb_dropped = 0;
+                srand(1);
+                for(unsigned i=0; i<nb_episodes; ++i) { // from the first nodes of the map
+                    state s(0.,&en.graph->nodes_vector[i]);
+                    if(mode == 0) {
+                        mcts_policy po(
+                            &en,
+                            true, // is_model_dynamic
+                            1., // discount_factor
+                            .707, // uct_parameter
+                            budget,
+                            100, // horizon
+                            1, // nb_rollouts
+                            1, // mcts_strategy_switch
+                            true, // reuse_tree
+                            1, // nb_search_threads
+                            false, // tree_parallel
+                            1., // virtual_loss
+                            0, // time_limit
+                            0, // calls_limit
+                            time_quantum,
+                            0., // widening_coefficient
+                            .5, // widening_exponent
+                            share_transpositions,
+                            0. // tree_memory_limit
+                        );
+                        nb_dropped += run_episode(en,po,s,nb_reused);
+                    } else {
+                        tmp_mcts_policy po(
+                            &en,
+                            true, // is_model_dynamic
+                            1., // discount_factor
+                            .707, // uct_parameter
+                            budget,
+                            100, // horizon
+                            1, // nb_rollouts
+                            1, // mcts_strategy_switch
+                            0., // regression_regularization
+                            1, // polynomial_regression_degree
+                            true, // reuse_tree
+                            1, // nb_search_threads
+                            0, // time_limit
+                            0, // calls_limit
+                            time_quantum,
+                            0., // widening_coefficient
+                            .5, // widening_exponent
+                            share_transpositions,
+                            0. // tree_memory_limit
+                        );
+                        nb_dropped += run_episode(en,po,s,nb_reused);
+                    }
+                }
+                std::cout << ((mode == 0) ? "uct " : "tmp_uct ") << time_quantum << " ";
+                std::cout << share_transpositions << " " << nb_reused << " " << nb_dropped << std::endl;
+                nb_failures += nb_dropped;
+            }
+        }
+    }
+    return (nb_failures > 0) ? 1 : 0;
+}
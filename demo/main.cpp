@@ -19,8 +19,11 @@ void print_informations(unsigned k, agent &ag) {
     std::cout << "step: " << k;
     std::cout << " time: " << ag.s.t;
     std::cout << " location: " << ag.s.get_name();
-    std::cout << " goto: " << ag.a.direction;
-    std::cout << " r: " << ag.r << std::endl;
+    std::cout << " goto: " << ag.s.get_direction(ag.a);
+    std::cout << " r: " << ag.r;
+    decision_statistics ds = ag.po->get_decision_statistics();
+    std::cout << " search: " << ds.duration << "us " << ds.nb_iterations << " iterations ";
+    std::cout << ds.nb_calls << " calls " << ds.peak_tree_bytes << " tree bytes" << std::endl;
 }
 
 /**
@@ -3,16 +3,16 @@
 
 class action {
 public:
-    std::string direction;
+    unsigned indice; ///< Indice of the edge amongst the outgoing edges of the current node
 
-    action() {}
+    action() : indice(0) {}
 
-    action(std::string _direction) : direction(_direction) {
+    action(unsigned _indice) : indice(_indice) {
         //
     }
 
     bool is_equal_to(action a) const {
-        return (direction.compare(a.direction) == 0);
+        return (indice == a.indice);
     }
 };
 
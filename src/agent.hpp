@@ -18,11 +18,11 @@ public:
      *
      * Constructs an object given the initial location.
      */
-    agent(std::unique_ptr<policy> &_po, map_node *ptr) :
+    agent(std::unique_ptr<policy> &_po, const map_node *ptr) :
         po(std::move(_po)),
         s(0.,ptr),
         s_p(0.,ptr),
-        a(""),
+        a(),
         r(0.)
     {}
 
@@ -35,6 +35,7 @@ public:
     }
 
     void step() {
+        po->step(a, s_p);
         s = s_p;
     }
 };
@@ -1,16 +1,18 @@
 #ifndef ENVIRONMENT_HPP_
 #define ENVIRONMENT_HPP_
 
-#include <map_node.hpp>
+#include <map_graph.hpp>
 #include <utils.hpp>
 
+/** @brief Number of rollouts advanced together by a batch rollout */
+constexpr unsigned ROLLOUT_LANES = 8;
+
 class environment {
 public:
     const double reward_scaling_max;
     const double goal_reward;
     const double dead_end_reward;
-    const std::vector<double> time_scale;
-    std::vector<map_node> nodes_vector;
+    std::unique_ptr<map_graph> graph; ///< Map graph in CSR layout
 
     /**
      * @brief Constructor
@@ -19,13 +21,11 @@ public:
         double _reward_scaling_max,
         double _goal_reward,
         double _dead_end_reward,
-        std::vector<double> &_time_scale,
-        std::vector<map_node> &_nodes_vector) :
+        std::unique_ptr<map_graph> &_graph) :
         reward_scaling_max(_reward_scaling_max),
         goal_reward(_goal_reward),
         dead_end_reward(_dead_end_reward),
-        time_scale(_time_scale),
-        nodes_vector(std::move(_nodes_vector))
+        graph(std::move(_graph))
     {
         //print_environment();
     }
@@ -33,17 +33,10 @@ public:
     /**
      * @brief Is action valid
      *
-     * Check whether the action is valid and if so modify the input indice as the one of the
-     * successor edge.
+     * Check whether the action designates one of the outgoing edges of the state's node.
      */
-    bool is_action_valid(const state &s, const action &a, unsigned &indice) const {
-        for(unsigned i=0; i<s.get_nb_edges(); ++i) {
-            if(s.nd_ptr->edges[i]->name.compare(a.direction) == 0) {
-                indice = i;
-                return true;
-            }
-        }
-        return false;
+    bool is_action_valid(const state &s, const action &a) const {
+        return a.indice < s.get_nb_edges();
     }
 
     /**
@@ -113,6 +106,7 @@ public:
      * direct lower element and the direct higher element.
      */
     std::tuple<unsigned,unsigned> get_uplow_indices(double t) const {
+        const std::vector<double> &time_scale = graph->time_scale;
         std::vector<double>::const_iterator up = std::upper_bound(time_scale.begin(), time_scale.end(), t);
         unsigned upind = up - time_scale.begin();
         if(upind == 0) {
@@ -128,7 +122,7 @@ public:
      * @brief Get time to successor
      *
      * Get the duration to go to the successor designated by the given indice.
-     * @param {unsigned} su_ind; indice of the successor in node->edges
+     * @param {unsigned} su_ind; indice of the edge amongst the outgoing edges of the node
      * @return Return the duration as a double.
      */
     double get_duration_until_successor(
@@ -136,18 +130,31 @@ public:
         double t_request,
         unsigned su_ind) const
     {
-        std::tuple<unsigned,unsigned> ti_ind = get_uplow_indices(t_request);
-        std::vector<double> c = s.nd_ptr->edges_costs.at(su_ind);
-        double c_m, c_p = c.at(std::get<1>(ti_ind));
-        double t_m, t_p = time_scale.at(std::get<1>(ti_ind));
-        if(std::get<0>(ti_ind) == std::get<1>(ti_ind)) {
-            //std::cout << "Warning, maximum range of duration matrix reached.\n";
-            c_m = c.at(std::get<0>(ti_ind) - 1);
-            t_m = time_scale.at(std::get<0>(ti_ind) - 1);
-        } else {
-            c_m = c.at(std::get<0>(ti_ind));
-            t_m = time_scale.at(std::get<0>(ti_ind));
+        return get_edge_duration(graph->get_edge_indice(s.nd_ptr->id,su_ind),t_request);
+    }
+
+    /**
+     * @brief Get edge duration
+     *
+     * Get the duration of the input edge at the requested time.
+     * If the segments of the graph are precomputed, the duration is a multiply-add on the
+     * segment of the requested time. Otherwise it is interpolated between the durations of
+     * the time steps surrounding the requested time, a time outside of the time scale using
+     * the first or the last interval, as map_graph::get_segment_indice.
+     * @param {unsigned} e; global indice of the edge
+     * @return Return the duration as a double.
+     */
+    double get_edge_duration(unsigned e, double t_request) const {
+        if(graph->are_segments_precomputed()) {
+            const double * sg = graph->get_edge_segments(e) + 2 * graph->get_segment_indice(t_request);
+            double duration = sg[0] * t_request + sg[1];
+            return is_less_than(duration,0.) ? 0. : duration;
         }
+        unsigned i_p = std::max(std::get<1>(get_uplow_indices(t_request)),1u); // the time scale has at least two steps
+        const double * c = graph->get_edge_durations(e);
+        const std::vector<double> &time_scale = graph->time_scale;
+        double c_m = c[i_p - 1], c_p = c[i_p];
+        double t_m = time_scale[i_p - 1], t_p = time_scale[i_p];
         double duration = ((c_p - c_m) / (t_p - t_m)) * t_request + (c_m * t_p - c_p * t_m) / (t_p - t_m);
         if(is_less_than(duration,0.)) {
             return 0.;
@@ -156,6 +163,150 @@ public:
         }
     }
 
+    /**
+     * @brief Rollout
+     *
+     * Simulate the uniform random policy from the input node and time, following the input
+     * edge first, until a terminal node is reached or the horizon is spent.
+     * Walks the node and edge indices of the graph directly and allocates nothing, the
+     * discount being updated multiplicatively. Same transitions and rewards as a sequence
+     * of calls to transition, the only non-zero reward being the terminal one.
+     * Template method.
+     * @param {unsigned} nd; id of the initial node, not terminal
+     * @param {double} t; initial time
+     * @param {unsigned} k; indice of the first edge amongst the outgoing edges of the node
+     * @param {bool} is_model_dynamic; request the durations at the time of each transition
+     * instead of at the reference time
+     * @param {unsigned &} nb_steps; incremented by the number of simulated transitions
+     * @return Return the discounted return of the rollout.
+     */
+    template <class G>
+    double rollout(
+        unsigned nd,
+        double t,
+        unsigned k,
+        bool is_model_dynamic,
+        double reference_time,
+        double discount_factor,
+        unsigned horizon,
+        G &generator,
+        unsigned &nb_steps) const
+    {
+        const map_graph &g = *graph;
+        double discount = 1.;
+        for(unsigned i=0; i<horizon; ++i) {
+            unsigned e = g.get_edge_indice(nd,k);
+            t += get_edge_duration(e,is_model_dynamic ? t : reference_time);
+            nd = g.successors[e];
+            ++nb_steps;
+            unsigned nb_edges = g.get_nb_edges(nd);
+            if(g.nodes_vector[nd].is_goal) {
+                return discount * (reward_from_duration(t) + goal_reward);
+            }
+            if(nb_edges == 0) {
+                return discount * (reward_from_duration(t) + dead_end_reward);
+            }
+            discount *= discount_factor;
+            k = uniform_integer(generator,0,nb_edges-1);
+        }
+        return 0.;
+    }
+
+    /**
+     * @brief Batch rollout
+     *
+     * Simulate several rollouts from the same node, time and first edge, see rollout.
+     * The rollouts are advanced one step at a time by groups of ROLLOUT_LANES lanes: at each
+     * step the interpolation segments of the followed edges are gathered, then the durations
+     * and the times of all the lanes are updated, finished lanes being masked. A single
+     * rollout samples the same return as rollout.
+     * The gathers, successors and masks are per lane and the lanes of a group finish at
+     * different steps, hence a batch is not faster per step than as many calls to rollout,
+     * see bench/rollout.cpp: more rollouts per leaf only lower the variance of its value.
+     * Template method.
+     * @param {unsigned} nb_rollouts; number of simulated rollouts
+     * @param {double *} returns; modified to the nb_rollouts discounted returns
+     * @param {unsigned &} nb_steps; incremented by the number of simulated transitions
+     */
+    template <class G>
+    void batch_rollout(
+        unsigned nd,
+        double t,
+        unsigned k,
+        bool is_model_dynamic,
+        double reference_time,
+        double discount_factor,
+        unsigned horizon,
+        G &generator,
+        unsigned nb_rollouts,
+        double * returns,
+        unsigned &nb_steps) const
+    {
+        const map_graph &g = *graph;
+        const bool segments_precomputed = g.are_segments_precomputed();
+        for(unsigned first=0; first<nb_rollouts; first+=ROLLOUT_LANES) {
+            unsigned nb_lanes = std::min(ROLLOUT_LANES,nb_rollouts-first);
+            unsigned nb_live = nb_lanes;
+            unsigned edge[ROLLOUT_LANES]; // followed edge of each lane
+            double time[ROLLOUT_LANES];
+            double request[ROLLOUT_LANES]; // time at which the duration of the edge is requested
+            double slope[ROLLOUT_LANES]; // interpolation segment of the edge at that time
+            double intercept[ROLLOUT_LANES];
+            double discount[ROLLOUT_LANES];
+            double live[ROLLOUT_LANES]; // 1 if the rollout of the lane is ongoing, 0 otherwise
+            for(unsigned l=0; l<ROLLOUT_LANES; ++l) {
+                edge[l] = g.get_edge_indice(nd,k);
+                time[l] = t;
+                discount[l] = 1.;
+                live[l] = (l < nb_lanes) ? 1. : 0.;
+            }
+            for(unsigned l=0; l<nb_lanes; ++l) {
+                returns[first+l] = 0.;
+            }
+            for(unsigned i=0; i<horizon && nb_live>0; ++i) {
+                for(unsigned l=0; l<ROLLOUT_LANES; ++l) { // gather the segments
+                    request[l] = is_model_dynamic ? time[l] : reference_time;
+                    slope[l] = 0.;
+                    intercept[l] = 0.;
+                    if(live[l] == 0.) {
+                        continue;
+                    }
+                    if(segments_precomputed) {
+                        const double * sg = g.get_edge_segments(edge[l]) + 2 * g.get_segment_indice(request[l]);
+                        slope[l] = sg[0];
+                        intercept[l] = sg[1];
+                    } else {
+                        intercept[l] = get_edge_duration(edge[l],request[l]);
+                    }
+                }
+                for(unsigned l=0; l<ROLLOUT_LANES; ++l) { // interpolate and move the live lanes
+                    double duration = slope[l] * request[l] + intercept[l];
+                    duration = is_less_than(duration,0.) ? 0. : duration;
+                    time[l] += live[l] * duration;
+                }
+                for(unsigned l=0; l<nb_lanes; ++l) { // reach the successors
+                    if(live[l] == 0.) {
+                        continue;
+                    }
+                    unsigned nd_p = g.successors[edge[l]];
+                    unsigned nb_edges = g.get_nb_edges(nd_p);
+                    ++nb_steps;
+                    if(g.nodes_vector[nd_p].is_goal || nb_edges == 0) {
+                        double terminal_reward = g.nodes_vector[nd_p].is_goal ? goal_reward : dead_end_reward;
+                        returns[first+l] = discount[l] * (reward_from_duration(time[l]) + terminal_reward);
+                        live[l] = 0.;
+                        --nb_live;
+                    } else {
+                        edge[l] = g.get_edge_indice(nd_p,uniform_integer(generator,0,nb_edges-1));
+                    }
+                }
+                for(unsigned l=0; l<ROLLOUT_LANES; ++l) {
+                    discount[l] *= discount_factor;
+                }
+            }
+        }
+    }
+
     /**
      * @brief Transition function
      */
@@ -166,12 +317,11 @@ public:
         double &r,
         state &s_p) const
     {
-        unsigned indice = 0;
-        if(is_action_valid(s,a,indice)) { // Go to edge
-            double duration = get_duration_until_successor(s,t_request,indice);
+        if(is_action_valid(s,a)) { // Go to edge
+            double duration = get_duration_until_successor(s,t_request,a.indice);
             s_p = state(
                 s.t + duration,
-                s.get_ptr_to_successor(indice)
+                s.get_ptr_to_successor(a.indice)
             );
             r = reward_function(s_p);
         } else { // Illegal action
@@ -182,11 +332,10 @@ public:
     /**
      * @brief Find node by name
      */
-    map_node * find_node_by_name(const std::string &name) {
-        for(auto &nd : nodes_vector) {
-            if(nd.name.compare(name) == 0) {
-                return &nd;
-            }
+    const map_node * find_node_by_name(const std::string &name) const {
+        unsigned id = 0;
+        if(graph->find_node_id(name,id)) {
+            return &graph->nodes_vector[id];
         }
         throw nonexistent_node_exception();
         return nullptr;
@@ -197,30 +346,24 @@ public:
      */
     void print_environment() const {
         std::cout << "Printing map graph:\nNodes:\n";
-        for(auto &nd : nodes_vector) {
+        for(auto &nd : graph->nodes_vector) {
             std::cout << " - " << nd.name << std::endl;
         }
         std::cout << "Edges:\n";
-        for(auto &nd : nodes_vector) {
+        for(auto &nd : graph->nodes_vector) {
             std::cout << "  - ";
             nd.print();
             std::cout << "    is linked to:\n";
-            for(unsigned k=0; k<nd.edges.size(); ++k) {
+            for(unsigned k=0; k<graph->get_nb_edges(nd.id); ++k) {
                 std::cout << "      - ";
-                nd.edges.at(k)->print();
+                graph->get_successor(nd.id,k)->print();
                 std::cout << "        with costs: ";
-                printv(nd.edges_costs.at(k));
-                /*
-                std::cout << "        which is linked to:\n";
-                for(auto &ndnd : nd.edges.at(k)->edges) {
-                    std::cout << "          - ";
-                    ndnd->print();
-                }
-                */
+                const double * c = graph->get_edge_durations(graph->get_edge_indice(nd.id,k));
+                printv(std::vector<double>(c,c + graph->get_nb_time_steps()));
             }
         }
         std::cout << "Time scale:\n";
-        printv(time_scale);
+        printv(graph->time_scale);
     }
 };
 
@@ -1,6 +1,43 @@
 #ifndef MAP_BUILDER_HPP_
 #define MAP_BUILDER_HPP_
 
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
+
+#include <map_file.hpp>
+#include <map_graph.hpp>
+#include <number_parsing.hpp>
+#include <parallel.hpp>
+#include <rng.hpp>
+
+/** @brief Stream of the random number generator used to build the topology of maps */
+constexpr uint64_t TOPOLOGY_STREAM = UINT64_MAX;
+
+/**
+ * @brief Csv row
+ *
+ * Location of a line of a memory-mapped csv duration matrix.
+ * The line is [begin, end) and its first two fields are [begin, orig_end) and
+ * [orig_end + 1, dest_end).
+ */
+struct csv_row {
+    const char * begin; ///< First character of the line
+    const char * orig_end; ///< Separator following the first field
+    const char * dest_end; ///< Separator following the second field
+    const char * end; ///< End of the line, line break excluded
+};
+
+/**
+ * @brief Edges list
+ *
+ * Edges of a map being generated, in order of creation.
+ */
+struct edges_list {
+    std::vector<unsigned> origins; ///< Origin node id of each edge
+    std::vector<unsigned> destinations; ///< Destination node id of each edge
+};
+
 class map_builder {
 public:
     // Parameters for auto-generated map
@@ -14,12 +51,15 @@ public:
     double duration_min;
     double duration_max;
     double lip;
+    bool procedural_durations; ///< Generate the durations on demand instead of storing them
 
     // Parameters for imported map
     std::string initial_location;
     std::string terminal_location;
     std::string input_duration_matrix;
     std::string csv_sep;
+    unsigned nb_threads; ///< Number of threads used to build maps, 0 for all hardware threads
+    uint64_t seed; ///< Seed of the random number generators of generated maps
 
     map_builder(
         unsigned _sampler_selector,
@@ -32,10 +72,13 @@ public:
         double _duration_min,
         double _duration_max,
         double _lip,
+        bool _procedural_durations,
         std::string _initial_location,
         std::string _terminal_location,
         std::string _input_duration_matrix,
-        std::string _csv_sep) :
+        std::string _csv_sep,
+        unsigned _nb_threads,
+        uint64_t _seed) :
         sampler_selector(_sampler_selector),
         nb_time_steps(_nb_time_steps),
         time_steps_width(_time_steps_width),
@@ -46,10 +89,13 @@ public:
         duration_min(_duration_min),
         duration_max(_duration_max),
         lip(_lip),
+        procedural_durations(_procedural_durations),
         initial_location(_initial_location),
         terminal_location(_terminal_location),
         input_duration_matrix(_input_duration_matrix),
-        csv_sep(_csv_sep)
+        csv_sep(_csv_sep),
+        nb_threads(_nb_threads),
+        seed(_seed)
     {}
 
     /**
@@ -78,23 +124,23 @@ public:
         }
     }
 
-    void first_order_random_uniform(std::vector<double> &vec, double &v) const {
+    void first_order_random_uniform(counter_rng &rng, std::vector<double> &vec, double &v) const {
         vec.push_back(vec.back() + v);
-        v = uniform_double(-lip,lip);
+        v = uniform_double(rng,-lip,lip);
     }
 
-    void secnd_order_random_uniform(std::vector<double> &vec, double &v) const {
+    void secnd_order_random_uniform(counter_rng &rng, std::vector<double> &vec, double &v) const {
         vec.push_back(vec.back() + v);
-        v += uniform_double(-lip / 2.,lip / 2.);
+        v += uniform_double(rng,-lip / 2.,lip / 2.);
         bound_variation(v);
     }
 
-    void secnd_order_epsilon_random_uniform(std::vector<double> &vec, double &v) const {
+    void secnd_order_epsilon_random_uniform(counter_rng &rng, std::vector<double> &vec, double &v) const {
         vec.push_back(vec.back() + v);
-        if(is_less_than(uniform_double(0.,1.),0.5)) {
-            v += uniform_double(-lip / 2.,lip / 2.);
+        if(is_less_than(uniform_double(rng,0.,1.),0.5)) {
+            v += uniform_double(rng,-lip / 2.,lip / 2.);
         }
-        if(is_less_than(uniform_double(0.,1.),0.1)) {
+        if(is_less_than(uniform_double(rng,0.,1.),0.1)) {
             v = -v;
         }
         bound_variation(v);
@@ -107,9 +153,9 @@ public:
         }
     }
 
-    void cos_fun(std::vector<double> &v, unsigned length) const {
+    void cos_fun(counter_rng &rng, std::vector<double> &v, unsigned length) const {
         double mag = ((double)length) * lip;
-        double increment = uniform_double(-mag,mag);
+        double increment = uniform_double(rng,-mag,mag);
         double x = 0.;
         double cs = v.back();
         for(unsigned i=0; i<length; ++i) {
@@ -120,22 +166,19 @@ public:
         }
     }
 
-    std::vector<double> cos_heuristic() const {
-        std::vector<double> v = {
-            uniform_double(duration_min,duration_max)
-        };
+    void cos_heuristic(counter_rng &rng, std::vector<double> &v) const {
+        v.assign(1,uniform_double(rng,duration_min,duration_max));
         unsigned min_length = 2;//((unsigned) nb_time_steps / 100.);
         unsigned max_length = 50;//((unsigned) nb_time_steps / 8.0);
         while(v.size() < nb_time_steps) {
-            unsigned length = uniform_integer(min_length,max_length);
-            if(uniform_integer(0,2) == 0) {
+            unsigned length = uniform_integer(rng,min_length,max_length);
+            if(uniform_integer(rng,0,2) == 0) {
                 const_fun(v,length);
             } else {
-                cos_fun(v,length);
+                cos_fun(rng,v,length);
             }
         }
         v.resize(nb_time_steps+1);
-        return v;
     }
 
     /**
@@ -144,22 +187,22 @@ public:
      * Append a new sampled duration to the duration vector and modify the
      * inter time-step duration variation according to the selected model.
      */
-    void append_duration(std::vector<double> &vec, double &v) const {
+    void append_duration(counter_rng &rng, std::vector<double> &vec, double &v) const {
         switch(sampler_selector) {
             case 0: {
-                first_order_random_uniform(vec,v);
+                first_order_random_uniform(rng,vec,v);
                 break;
             }
             case 1: {
-                secnd_order_random_uniform(vec,v);
+                secnd_order_random_uniform(rng,vec,v);
                 break;
             }
             case 2: {
-                secnd_order_epsilon_random_uniform(vec,v);
+                secnd_order_epsilon_random_uniform(rng,vec,v);
                 break;
             }
             default: {
-                first_order_random_uniform(vec,v);
+                first_order_random_uniform(rng,vec,v);
                 break;
             }
         }
@@ -168,159 +211,226 @@ public:
     /**
      * @brief Sample durations
      *
-     * Build a vector containing the durations associated to an edge
-     * at each time step.
+     * Fill the input vector with the durations associated to an edge at each time step,
+     * drawn from the given random number generator.
      */
-    std::vector<double> sample_durations() const {
+    void sample_durations(counter_rng &rng, std::vector<double> &vec) const {
         if(sampler_selector == 3) { // case 3
-            return cos_heuristic();
+            cos_heuristic(rng,vec);
         } else { // cases 0 1 2 or default
-            std::vector<double> vec = {
-                uniform_double(duration_min,duration_max)
-            };
-            double v = uniform_double(-lip,lip);
+            vec.assign(1,uniform_double(rng,duration_min,duration_max));
+            double v = uniform_double(rng,-lip,lip);
             for(unsigned j=0; j<nb_time_steps; ++j) {
-                append_duration(vec,v);
+                append_duration(rng,vec,v);
                 if(is_less_than(vec.back(),0.)) {
                     vec.back() = 0.;
                 }
             }
-            return vec;
         }
     }
 
     /**
      * @brief Write time scale
      *
-     * Write the time scale ie first line of a duration matrix in the corresponding format.
+     * Write the evenly spaced time scale of a generated map, of nb_time_steps+1 time steps.
+     * A time_scale_exception is thrown if nb_time_steps is 0, since the durations are
+     * interpolated between two time steps.
      */
-    void write_time_scale(std::vector<std::vector<std::string>> &dm) const {
-        std::vector<std::string> first_line;
-        first_line.push_back("start");
-        first_line.push_back("goal");
+    void write_time_scale(map_graph &g) const {
+        if(nb_time_steps < 1) {
+            throw time_scale_exception();
+        }
+        g.time_scale.clear();
         for(unsigned i=0; i<nb_time_steps+1; ++i) {
-            first_line.push_back(std::to_string(i * time_steps_width));
+            g.time_scale.push_back((double) (i * time_steps_width));
         }
-        dm.push_back(first_line);
     }
 
     /**
      * @brief Write random edge
      *
-     * Write a line containing the names of the starting node of the edge; the ending node
-     * of the edge; and the durations for each on of the time scale components.
-     * The line is pushed back to the input duration matrix.
+     * Append an edge to the edges list; its durations are sampled once the whole list is
+     * written, see set_random_edges.
      */
-    void write_random_edge(
-        std::vector<std::vector<std::string>> &dm,
-        const std::string &orig_node_name,
-        const std::string &dest_node_name) const
-    {
-        std::vector<std::string> new_line;
-        new_line.push_back(orig_node_name);
-        new_line.push_back(dest_node_name);
-        std::vector<double> durations = sample_durations();
-        for(auto &d : durations) {
-            new_line.push_back(std::to_string(d));
-        }
-        dm.push_back(new_line);
+    void write_random_edge(edges_list &el, unsigned orig_id, unsigned dest_id) const {
+        el.origins.push_back(orig_id);
+        el.destinations.push_back(dest_id);
+    }
+
+    /**
+     * @brief Sample edge durations
+     *
+     * The durations of the e-th edge of the CSR layout are drawn from the e-th stream of the
+     * seed, hence they can be sampled in any order, or sampled again.
+     * @param {unsigned} e; indice of the edge in the CSR layout
+     * @param {double *} output; written with the nb_time_steps+1 durations of the edge
+     * @param {std::vector<double> &} buffer; sampling buffer, reused across calls
+     */
+    void sample_edge_durations(unsigned e, double * output, std::vector<double> &buffer) const {
+        counter_rng rng(seed,e);
+        sample_durations(rng,buffer);
+        std::copy(buffer.begin(),buffer.end(),output);
+    }
+
+    /**
+     * @brief Set random edges
+     *
+     * Build the CSR layout of the graph from the edges list and sample the durations of
+     * each edge straight into the duration tensor.
+     * The edges are split in contiguous ranges sampled concurrently, see
+     * sample_edge_durations, hence the map does not depend on the number of threads.
+     * If the durations are procedural, the graph generates them on demand from a copy of
+     * the builder instead, and they are the same as if they were stored.
+     */
+    void set_random_edges(map_graph &g, const edges_list &el) const {
+        if(procedural_durations) {
+            map_builder mb = *this;
+            g.duration_generator = [mb](unsigned e, double * output) {
+                static thread_local std::vector<double> buffer;
+                mb.sample_edge_durations(e,output,buffer);
+            };
+            g.set_adjacency(el.origins,el.destinations);
+            return;
+        }
+        unsigned nb_ts = g.get_nb_time_steps();
+        g.set_adjacency(el.origins,el.destinations);
+        unsigned nb_edges = g.get_nb_edges();
+        unsigned nb_tasks = std::max(1u,std::min(get_nb_threads(nb_threads),nb_edges));
+        parallel_run(nb_tasks,[&](unsigned k) {
+            std::vector<double> buffer;
+            buffer.reserve(nb_ts + 1);
+            for(unsigned e=(size_t) k*nb_edges/nb_tasks; e<(size_t) (k+1)*nb_edges/nb_tasks; ++e) {
+                sample_edge_durations(e,&g.durations_storage[(size_t) e * nb_ts],buffer);
+            }
+        });
+    }
+
+    /**
+     * @brief Create nodes
+     *
+     * Create the nodes n0 to n<nb_nodes-1>.
+     * @return Return the ids of the created nodes.
+     */
+    std::vector<unsigned> create_nodes(map_graph &g) const {
+        std::vector<unsigned> nodes_ids;
+        for(unsigned i=0; i<nb_nodes; ++i) {
+            nodes_ids.push_back(get_node_id("n" + std::to_string(i),g));
+        }
+        return nodes_ids;
     }
 
     /**
      * @brief Build a random connected directed duration matrix
      *
-     * @return Return the duration matrix.
+     * Build the graph of a random connected directed map.
+     * The in-degree of each node is counted while the edges are drawn, hence the
+     * generation is linear in the number of edges.
      */
-    std::vector<std::vector<std::string>> build_connected_directed_duration_matrix() const {
-        std::vector<std::vector<std::string>> dm;
+    void build_connected_directed_duration_matrix(map_graph &g) const {
+        edges_list el;
         // 0. time scale
-        write_time_scale(dm);
+        write_time_scale(g);
         // 1. Nodes
-        std::vector<std::string> nodes_names;
-        for(unsigned i=0; i<nb_nodes; ++i) {
-            nodes_names.push_back("n" + std::to_string(i));
-        }
+        std::vector<unsigned> nodes_ids = create_nodes(g);
+        std::vector<unsigned> in_degrees(nodes_ids.size(),0);
+        counter_rng rng(seed,TOPOLOGY_STREAM);
+        el.origins.reserve((size_t) nb_nodes * (min_nb_edges_per_node + 1));
+        el.destinations.reserve((size_t) nb_nodes * (min_nb_edges_per_node + 1));
         // 2. Build minimum of edges per node
         for(unsigned i=0; i<nb_nodes; ++i) {
             for(unsigned k=0; k<min_nb_edges_per_node; ++k) {
                 unsigned dest_ind = i;
                 while(dest_ind == i) {
-                    dest_ind = rand_indice(nodes_names);
+                    dest_ind = uniform_integer(rng,0,nodes_ids.size() - 1);
                 }
-                write_random_edge(dm,nodes_names.at(i),nodes_names.at(dest_ind));
+                in_degrees.at(dest_ind)++;
+                write_random_edge(el,nodes_ids.at(i),nodes_ids.at(dest_ind));
             }
         }
         // 3. Additional edges for non-reachable nodes
         for(unsigned i=0; i<nb_nodes; ++i) {
-            bool is_reachable = false;
-            for(unsigned k=1; k<dm.size(); ++k) {
-                if(dm.at(k).at(1).compare(nodes_names.at(i)) == 0) {
-                    is_reachable = true;
-                    break;
-                }
-            }
-            if(!is_reachable) {
+            if(in_degrees.at(i) == 0) {
                 unsigned orig_ind = i;
                 while(orig_ind == i) {
-                    orig_ind = rand_indice(nodes_names);
+                    orig_ind = uniform_integer(rng,0,nodes_ids.size() - 1);
                 }
-                write_random_edge(dm,nodes_names.at(orig_ind),nodes_names.at(i));
+                write_random_edge(el,nodes_ids.at(orig_ind),nodes_ids.at(i));
             }
         }
-        return dm;
+        set_random_edges(g,el);
     }
 
     /**
      * @brief Does edge exist
+     *
+     * @param {const std::unordered_set<uint64_t> &} edges; hash set of the existing edges,
+     * see get_edge_key
+     * @return Return true if the edge is a self-loop or is already in the hash set.
      */
     bool does_edge_exist(
-        std::vector<std::vector<std::string>> dm,
-        std::string orig_name,
-        std::string dest_name) const
+        const std::unordered_set<uint64_t> &edges,
+        unsigned orig_ind,
+        unsigned dest_ind) const
     {
-        if(orig_name.compare(dest_name) == 0) {
-            return true;
-        } else {
-            for(unsigned i=1; i<dm.size(); ++i) {
-                if(dm.at(i).at(0).compare(orig_name) == 0) {
-                    if(dm.at(i).at(1).compare(dest_name) == 0) {
-                        return true;
-                    }
-                }
-            }
-            return false;
-        }
+        return (orig_ind == dest_ind) || (edges.count(get_edge_key(orig_ind,dest_ind)) > 0);
+    }
+
+    /**
+     * @brief Get edge key
+     *
+     * @return Return the key of the edge linking the given nodes in an edges hash set.
+     */
+    uint64_t get_edge_key(unsigned orig_ind, unsigned dest_ind) const {
+        return ((uint64_t) orig_ind << 32) | dest_ind;
     }
 
     /**
      * @brief Build a random connected symmetric directed duration matrix
      *
-     * @return Return the duration matrix.
+     * Build the graph of a random connected symmetric directed map.
+     * Existing edges are looked up in a hash set, hence the generation
+     * is linear in the number of edges in expectation, as long as the nodes are far from
+     * being linked to all the others.
+     * The number of edges of a node is capped to nb_nodes - 1.
      */
-    std::vector<std::vector<std::string>> build_connected_symmetric_directed_duration_matrix() const {
-        std::vector<std::vector<std::string>> dm;
+    void build_connected_symmetric_directed_duration_matrix(map_graph &g) const {
+        edges_list el;
         // 0. time scale
-        write_time_scale(dm);
+        write_time_scale(g);
         // 1. Build minimum of edges per node + the come-back edge
-        std::vector<std::string> nodes_names;
-        for(unsigned i=0; i<nb_nodes; ++i) {
-            nodes_names.push_back("n" + std::to_string(i));
-        }
-        std::vector<unsigned> nodes_edges_counter(nodes_names.size(),0);
+        std::vector<unsigned> nodes_ids = create_nodes(g);
+        counter_rng rng(seed,TOPOLOGY_STREAM);
+        std::vector<unsigned> nodes_edges_counter(nodes_ids.size(),0);
+        std::unordered_set<uint64_t> edges;
+        unsigned max_nb_edges_per_node = std::min(min_nb_edges_per_node,(nb_nodes > 0) ? nb_nodes - 1 : 0);
+        el.origins.reserve((size_t) 2 * nb_nodes * max_nb_edges_per_node);
+        el.destinations.reserve((size_t) 2 * nb_nodes * max_nb_edges_per_node);
+        edges.reserve((size_t) 2 * nb_nodes * max_nb_edges_per_node);
         // 2. Edges
         for(unsigned i=0; i<nb_nodes; ++i) {
-            for(unsigned k=nodes_edges_counter.at(i); k<min_nb_edges_per_node; ++k) {
+            for(unsigned k=nodes_edges_counter.at(i); k<max_nb_edges_per_node; ++k) {
                 unsigned dest_ind = i;
-                while(dest_ind == i || does_edge_exist(dm,nodes_names.at(i),nodes_names.at(dest_ind))) {
-                    dest_ind = rand_indice(nodes_names);
+                while(does_edge_exist(edges,i,dest_ind)) {
+                    dest_ind = uniform_integer(rng,0,nodes_ids.size() - 1);
                 }
                 nodes_edges_counter.at(i)++;
                 nodes_edges_counter.at(dest_ind)++;
-                write_random_edge(dm,nodes_names.at(i),nodes_names.at(dest_ind));
-                write_random_edge(dm,nodes_names.at(dest_ind),nodes_names.at(i));
+                edges.insert(get_edge_key(i,dest_ind));
+                edges.insert(get_edge_key(dest_ind,i));
+                write_random_edge(el,nodes_ids.at(i),nodes_ids.at(dest_ind));
+                write_random_edge(el,nodes_ids.at(dest_ind),nodes_ids.at(i));
             }
         }
-        return dm;
+        set_random_edges(g,el);
+    }
+
+    /**
+     * @brief Get sequential node id
+     *
+     * Get the id of the node n<i>_<j> of a sequential map, created if necessary.
+     */
+    unsigned get_sequential_node_id(unsigned i, unsigned j, map_graph &g) const {
+        return get_node_id("n" + std::to_string(i) + "_" + std::to_string(j),g);
     }
 
     /**
@@ -337,169 +447,391 @@ public:
      * node.
      * @note The names of the nodes are n<i>_<j> with i the path's number and j the depth.
      * Each indices start from 0.
-     * @return Return the duration matrix.
      */
-    std::vector<std::vector<std::string>> build_sequential_duration_matrix() const {
-        std::vector<std::vector<std::string>> dm;
+    void build_sequential_duration_matrix(map_graph &g) const {
+        edges_list el;
         // 0. time scale
-        write_time_scale(dm);
+        write_time_scale(g);
         // 1. Create paths between starting and goal nodes
         for(unsigned i=0; i<nb_links; ++i) {
             for(unsigned j=0; j<nb_nodes_per_link-1; ++j) {
-                std::string orig_name = "n" + std::to_string(i) + "_" + std::to_string(j);
-                std::string dest_name = "n" + std::to_string(i) + "_" + std::to_string(j+1);
-                write_random_edge(dm,orig_name,dest_name);
-                write_random_edge(dm,dest_name,orig_name);
+                unsigned orig_id = get_sequential_node_id(i,j,g);
+                unsigned dest_id = get_sequential_node_id(i,j+1,g);
+                write_random_edge(el,orig_id,dest_id);
+                write_random_edge(el,dest_id,orig_id);
             }
         }
         // 2. Link starting and goal nodes to the paths
+        unsigned initial_id = get_node_id(initial_location,g);
         for(unsigned i=0; i<nb_links; ++i) {
-            std::string dest_name = "n" + std::to_string(i) + "_0";
-            write_random_edge(dm,initial_location,dest_name);
-            write_random_edge(dm,dest_name,initial_location);
+            unsigned dest_id = get_sequential_node_id(i,0,g);
+            write_random_edge(el,initial_id,dest_id);
+            write_random_edge(el,dest_id,initial_id);
         }
+        unsigned terminal_id = get_node_id(terminal_location,g);
         for(unsigned i=0; i<nb_links; ++i) {
-            std::string orig_name = "n" + std::to_string(i) + "_" + std::to_string(nb_nodes_per_link - 1);
-            write_random_edge(dm,orig_name,terminal_location);
+            unsigned orig_id = get_sequential_node_id(i,nb_nodes_per_link - 1,g);
+            write_random_edge(el,orig_id,terminal_id);
         }
         // 3. Create connexions between paths
         for(unsigned i=0; i<nb_links; ++i) {
             for(unsigned j=0; j<nb_nodes_per_link; ++j) {
-                std::string orig_name = "n" + std::to_string(i) + "_" + std::to_string(j);
+                unsigned orig_id = get_sequential_node_id(i,j,g);
                 for(unsigned k=0; k<nb_links; ++k) {
                     if(k != i) {
-                        std::string dest_name = "n" + std::to_string(k) + "_" + std::to_string(j);
-                        write_random_edge(dm,orig_name,dest_name);
+                        write_random_edge(el,orig_id,get_sequential_node_id(k,j,g));
                     }
                 }
             }
         }
-        return dm;
+        set_random_edges(g,el);
+    }
+
+    /**
+     * @brief Split csv line
+     *
+     * Locate the origin name, the destination name and the durations of a csv line.
+     * @return Return false if the line has less than three fields.
+     */
+    bool split_csv_line(const char * begin, const char * end, csv_row &row) const {
+        char sep = csv_sep.at(0);
+        row.begin = begin;
+        row.end = end;
+        row.orig_end = static_cast<const char *>(std::memchr(begin,sep,end - begin));
+        if(row.orig_end == nullptr) {
+            return false;
+        }
+        row.dest_end = static_cast<const char *>(std::memchr(row.orig_end + 1,sep,end - row.orig_end - 1));
+        return row.dest_end != nullptr;
+    }
+
+    /**
+     * @brief Parse csv numbers
+     *
+     * Parse the separated numbers written in [begin, end) into the output array.
+     * @return Return false if the range does not hold exactly nb_values valid numbers.
+     */
+    bool parse_csv_numbers(
+        const char * begin,
+        const char * end,
+        unsigned nb_values,
+        double * output) const
+    {
+        char sep = csv_sep.at(0);
+        const char * p = begin;
+        for(unsigned j=0; j<nb_values; ++j) {
+            const char * q = static_cast<const char *>(std::memchr(p,sep,end - p));
+            q = (q == nullptr) ? end : q;
+            if(!parse_double(p,q,output[j]) || ((q == end) != (j == nb_values - 1))) {
+                return false;
+            }
+            p = q + 1;
+        }
+        return nb_values > 0;
     }
 
     /**
-     * @brief Extract the duration matrix
+     * @brief Find csv lines
+     *
+     * Locate the non-empty lines written in [begin, end) and split them.
      */
-    std::vector<std::vector<std::string>> extract_duration_matrix() const {
-        std::filebuf fb;
-        if (fb.open(input_duration_matrix,std::ios::in)) {
-            std::vector<std::vector<std::string>> dm;
-            std::istream is(&fb);
-            while(true) {
-                std::vector<std::string> result;
-                std::string line;
-                std::getline(is,line);
-                std::stringstream ss(line);
-                std::string cell;
-
-                while(std::getline(ss,cell,csv_sep.at(0))) {
-                    result.push_back(cell);
+    void find_csv_lines(const char * begin, const char * end, std::vector<csv_row> &rows) const {
+        const char * p = begin;
+        while(p < end) {
+            const char * line_end = static_cast<const char *>(std::memchr(p,'\n',end - p));
+            const char * next = (line_end == nullptr) ? end : line_end + 1;
+            line_end = (line_end == nullptr) ? end : line_end;
+            if(line_end > p && *(line_end - 1) == '\r') {
+                --line_end;
+            }
+            if(line_end > p) {
+                rows.emplace_back();
+                if(!split_csv_line(p,line_end,rows.back())) {
+                    throw duration_matrix_format_exception();
                 }
-                if(is.eof()) {
-                    break;
-                } else {
-                    dm.push_back(result);
+            }
+            p = next;
+        }
+    }
+
+    /**
+     * @brief Load csv duration matrix
+     *
+     * Load the csv duration matrix at the input path into the graph.
+     * The file is memory-mapped and split into line-aligned chunks that are processed in
+     * parallel in two passes: the lines are first located, then, once the nodes are created
+     * and the CSR layout is known, the durations of each line are parsed straight into the
+     * duration tensor of the graph.
+     * A time scale of less than two time steps throws a time_scale_exception.
+     * The loading throughput is printed.
+     */
+    void load_csv_duration_matrix(map_graph &g) const {
+        auto t_start = std::chrono::steady_clock::now();
+        mapped_file file(input_duration_matrix);
+        const char * file_end = file.data + file.size;
+        // 0. Extract time scale
+        const char * body = static_cast<const char *>(std::memchr(file.data,'\n',file.size));
+        body = (body == nullptr) ? file_end : body + 1;
+        csv_row header;
+        if(!split_csv_line(file.data,(body < file_end) ? body - 1 : body,header)) {
+            throw duration_matrix_format_exception();
+        }
+        if(header.end > header.begin && *(header.end - 1) == '\r') {
+            --header.end;
+        }
+        const char * p = header.dest_end + 1;
+        unsigned nb_time_steps = std::count(p,header.end,csv_sep.at(0)) + 1;
+        if(nb_time_steps < 2) {
+            throw time_scale_exception();
+        }
+        g.time_scale.resize(nb_time_steps);
+        if(!parse_csv_numbers(p,header.end,nb_time_steps,g.time_scale.data())) {
+            throw duration_matrix_format_exception();
+        }
+        double tref = g.time_scale.at(0);
+        for(auto &t : g.time_scale) {
+            t -= tref;
+        }
+        // 1. Locate lines, chunk by chunk
+        unsigned nb_chunks = get_nb_threads(nb_threads);
+        std::vector<const char *> bounds = {body};
+        for(unsigned k=1; k<nb_chunks; ++k) {
+            const char * b = body + (file_end - body) * k / nb_chunks;
+            b = std::max(b,bounds.back());
+            const char * line_end = static_cast<const char *>(std::memchr(b,'\n',file_end - b));
+            bounds.push_back((line_end == nullptr) ? file_end : line_end + 1);
+        }
+        bounds.push_back(file_end);
+        std::vector<std::vector<csv_row>> chunks(nb_chunks);
+        parallel_run(nb_chunks,[&](unsigned k) {
+            find_csv_lines(bounds[k],bounds[k+1],chunks[k]);
+        });
+        // 2. Create nodes, assign termination criterion and build the CSR layout
+        std::vector<unsigned> origins, destinations;
+        for(auto &chunk : chunks) {
+            for(auto &row : chunk) {
+                origins.push_back(get_node_id(std::string(row.begin,row.orig_end),g));
+                destinations.push_back(get_node_id(std::string(row.orig_end + 1,row.dest_end),g));
+            }
+        }
+        std::vector<unsigned> positions = g.set_adjacency(origins,destinations);
+        // 3. Parse durations, chunk by chunk
+        std::vector<unsigned> first_rows = {0};
+        for(auto &chunk : chunks) {
+            first_rows.push_back(first_rows.back() + chunk.size());
+        }
+        parallel_run(nb_chunks,[&](unsigned k) {
+            for(unsigned i=0; i<chunks[k].size(); ++i) {
+                const csv_row &row = chunks[k][i];
+                double * output = &g.durations_storage[(size_t) positions[first_rows[k] + i] * nb_time_steps];
+                if(!parse_csv_numbers(row.dest_end + 1,row.end,nb_time_steps,output)) {
+                    throw duration_matrix_format_exception();
                 }
             }
-            fb.close();
-            return dm;
-        } else {
-            throw duration_matrix_file_exception();
+        });
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        std::cout << "Duration matrix loaded: " << origins.size() << " rows, ";
+        std::cout << file.size << " bytes in " << 1e3 * elapsed << "ms (";
+        std::cout << origins.size() / elapsed << " rows/s, ";
+        std::cout << file.size / elapsed << " bytes/s)" << std::endl;
+    }
+
+    /**
+     * @brief Open binary duration matrix
+     *
+     * Memory-map the binary map file at the input path; the CSR arrays of the graph point
+     * directly into the file and only the nodes and the time scale are copied.
+     * Every section is checked to lie within the file and the names, CSR offsets and
+     * successors to be consistent before they are used, a truncated or corrupt file throwing
+     * a map_file_exception.
+     * See map_file_header for the file layout.
+     */
+    void open_binary_duration_matrix(map_graph &g) const {
+        g.file.reset(new mapped_file(input_duration_matrix));
+        const char * data = g.file->data;
+        map_file_header h;
+        if(g.file->size < sizeof(h)) {
+            throw map_file_exception();
+        }
+        std::memcpy(&h,data,sizeof(h));
+        uint64_t nb_nodes = h.nb_nodes;
+        uint64_t nb_edges = h.nb_edges;
+        uint64_t nb_time_steps = h.nb_time_steps;
+        if(std::memcmp(h.magic,MAP_FILE_MAGIC,sizeof(h.magic)) != 0
+        || h.version != MAP_FILE_VERSION
+        || h.file_size != g.file->size
+        || nb_time_steps < 2 // interpolation reads the durations of two consecutive steps
+        || !is_map_file_section_valid(h.name_offsets_offset,nb_nodes + 1,sizeof(uint32_t),h.file_size)
+        || !is_map_file_section_valid(h.offsets_offset,nb_nodes + 1,sizeof(uint32_t),h.file_size)
+        || !is_map_file_section_valid(h.successors_offset,nb_edges,sizeof(uint32_t),h.file_size)
+        || !is_map_file_section_valid(h.time_scale_offset,nb_time_steps,sizeof(double),h.file_size)
+        || !is_map_file_section_valid(h.durations_offset,nb_edges * nb_time_steps,sizeof(double),h.file_size)) {
+            throw map_file_exception();
+        }
+        const uint32_t * name_offsets = reinterpret_cast<const uint32_t *>(data + h.name_offsets_offset);
+        const uint32_t * offsets = reinterpret_cast<const uint32_t *>(data + h.offsets_offset);
+        const uint32_t * successors = reinterpret_cast<const uint32_t *>(data + h.successors_offset);
+        if(!is_map_file_section_valid(h.names_offset,name_offsets[nb_nodes],1,h.file_size)
+        || offsets[0] != 0
+        || offsets[nb_nodes] != nb_edges) {
+            throw map_file_exception();
+        }
+        for(uint64_t i=0; i<nb_nodes; ++i) {
+            if(name_offsets[i] > name_offsets[i+1] || offsets[i] > offsets[i+1]) {
+                throw map_file_exception();
+            }
+        }
+        for(uint64_t e=0; e<nb_edges; ++e) {
+            if(successors[e] >= nb_nodes) {
+                throw map_file_exception();
+            }
+        }
+        g.nodes_vector.reserve(h.nb_nodes);
+        g.name_table.reserve(h.nb_nodes);
+        for(unsigned i=0; i<h.nb_nodes; ++i) {
+            std::string name(data + h.names_offset + name_offsets[i],name_offsets[i+1] - name_offsets[i]);
+            unsigned id = 0;
+            if(g.find_node_id(name,id)) { // duplicate name
+                throw map_file_exception();
+            }
+            g.add_node(name,name.compare(terminal_location) == 0);
         }
+        const double * ts = reinterpret_cast<const double *>(data + h.time_scale_offset);
+        g.time_scale.assign(ts,ts + h.nb_time_steps);
+        g.set_views(
+            reinterpret_cast<const unsigned *>(offsets),
+            reinterpret_cast<const unsigned *>(successors),
+            reinterpret_cast<const double *>(data + h.durations_offset),
+            h.nb_edges
+        );
     }
 
     /**
      * @brief Save duration matrix
      *
-     * Save the input duration matrix at the specified output path.
+     * Save the map at the specified output path in the given format.
+     * @param {unsigned} format; 0: csv, 1: binary
      */
     void save_duration_matrix(
-        const std::vector<std::vector<std::string>> &dm,
-        const std::string &path) const
+        const map_graph &g,
+        const std::string &path,
+        unsigned format) const
     {
+        switch(format) {
+            case 1: {
+                save_binary_duration_matrix(g,path);
+                break;
+            }
+            default: {
+                save_csv_duration_matrix(g,path);
+            }
+        }
+    }
+
+    /**
+     * @brief Save csv duration matrix
+     *
+     * The first line is the time scale and each following line is an edge, sorted by
+     * origin node.
+     */
+    void save_csv_duration_matrix(const map_graph &g, const std::string &path) const {
         std::ofstream ofs;
         ofs.open(path);
-        assert(dm.size() > 1);
-        assert(dm.at(0).size() > 2);
-        unsigned nrow = dm.size();
-        unsigned ncol = dm.at(0).size();
-        for(unsigned i=0; i<nrow; ++i) {
-            for(unsigned j=0; j<ncol; ++j) {
-                ofs << dm.at(i).at(j);
-                if(j < ncol - 1) {
-                    ofs << csv_sep.at(0);
+        char sep = csv_sep.at(0);
+        ofs << "start" << sep << "goal";
+        for(auto &t : g.time_scale) {
+            ofs << sep << std::to_string(t);
+        }
+        ofs << "\n";
+        for(auto &nd : g.nodes_vector) {
+            for(unsigned k=0; k<g.get_nb_edges(nd.id); ++k) {
+                ofs << nd.name << sep << g.get_successor(nd.id,k)->name;
+                const double * c = g.get_edge_durations(g.get_edge_indice(nd.id,k));
+                for(unsigned j=0; j<g.get_nb_time_steps(); ++j) {
+                    ofs << sep << std::to_string(c[j]);
                 }
+                ofs << "\n";
             }
-            ofs << "\n";
         }
         ofs.close();
     }
 
     /**
-     * @brief Is node already created
+     * @brief Write section
+     *
+     * Pad the output stream with zeros up to the given offset, then write the section.
+     * @param {uint64_t &} position; current position in the stream, updated
      */
-    bool is_node_already_created(std::string s, const std::vector<map_node> &v) const {
-        for(auto &elt: v) {
-            if(elt.name.compare(s) == 0) {
-                return true;
-            }
+    void write_section(
+        std::ofstream &ofs,
+        uint64_t &position,
+        uint64_t offset,
+        const void * data,
+        uint64_t size) const
+    {
+        assert(position <= offset);
+        for(; position < offset; ++position) {
+            ofs.put('\0');
         }
-        return false;
+        ofs.write(static_cast<const char *>(data),size);
+        position += size;
     }
 
     /**
-     * @brief Get durations
+     * @brief Save binary duration matrix
+     *
+     * See map_file_header for the file layout.
      */
-    std::vector<double> get_durations(
-        unsigned i,
-        const std::vector<std::vector<std::string>> &dm) const
-    {
-        std::vector<double> v;
-        for(unsigned j=2; j<dm.at(i).size(); ++j) {
-            v.push_back(std::stod(dm.at(i).at(j)));
+    void save_binary_duration_matrix(const map_graph &g, const std::string &path) const {
+        std::string names;
+        std::vector<uint32_t> name_offsets = {0};
+        for(auto &nd : g.nodes_vector) {
+            names += nd.name;
+            name_offsets.push_back(names.size());
         }
-        return v;
+        uint64_t nb_nodes = g.get_nb_nodes();
+        uint64_t nb_edges = g.get_nb_edges();
+        uint64_t nb_time_steps = g.get_nb_time_steps();
+        map_file_header h;
+        std::memset(&h,0,sizeof(h));
+        std::memcpy(h.magic,MAP_FILE_MAGIC,sizeof(h.magic));
+        h.version = MAP_FILE_VERSION;
+        h.nb_nodes = nb_nodes;
+        h.nb_edges = nb_edges;
+        h.nb_time_steps = nb_time_steps;
+        h.names_offset = map_file_align(sizeof(h));
+        h.name_offsets_offset = map_file_align(h.names_offset + names.size());
+        h.offsets_offset = map_file_align(h.name_offsets_offset + sizeof(uint32_t) * (nb_nodes + 1));
+        h.successors_offset = map_file_align(h.offsets_offset + sizeof(uint32_t) * (nb_nodes + 1));
+        h.time_scale_offset = map_file_align(h.successors_offset + sizeof(uint32_t) * nb_edges);
+        h.durations_offset = map_file_align(h.time_scale_offset + sizeof(double) * nb_time_steps);
+        h.file_size = h.durations_offset + sizeof(double) * nb_edges * nb_time_steps;
+        std::ofstream ofs(path,std::ios::out | std::ios::binary);
+        uint64_t position = 0;
+        write_section(ofs,position,0,&h,sizeof(h));
+        write_section(ofs,position,h.names_offset,names.data(),names.size());
+        write_section(ofs,position,h.name_offsets_offset,name_offsets.data(),sizeof(uint32_t) * (nb_nodes + 1));
+        write_section(ofs,position,h.offsets_offset,g.offsets,sizeof(uint32_t) * (nb_nodes + 1));
+        write_section(ofs,position,h.successors_offset,g.successors,sizeof(uint32_t) * nb_edges);
+        write_section(ofs,position,h.time_scale_offset,g.time_scale.data(),sizeof(double) * nb_time_steps);
+        write_section(ofs,position,h.durations_offset,nullptr,0);
+        for(unsigned e=0; e<nb_edges; ++e) { // edge by edge, the durations may be procedural
+            write_section(ofs,position,position,g.get_edge_durations(e),sizeof(double) * nb_time_steps);
+        }
+        ofs.close();
     }
 
     /**
-     * @brief Build environment from duration matrix
+     * @brief Get node id
+     *
+     * Get the id of the node with the given name, the node is created if necessary.
      */
-    void build_time_scale_and_map_from_duration_matrix(
-        const std::vector<std::vector<std::string>> &dm,
-        std::vector<double> &ts,
-        std::vector<map_node> &nv) const
-    {
-        // 0. Extract time scale
-        double tref = std::stod(dm.at(0).at(2));
-        for(unsigned j=2; j<dm.at(0).size(); ++j) {
-            ts.push_back(std::stod(dm.at(0).at(j)) - tref);
-        }
-        // 1. Create nodes and assign termination criterion
-        for(unsigned i=1; i<dm.size(); ++i) {
-            for(unsigned j=0; j<2; ++j) {
-                if(!is_node_already_created(dm.at(i).at(j),nv)) {
-                    if(dm.at(i).at(j).compare(terminal_location) == 0) {
-                        nv.emplace_back(map_node(dm.at(i).at(j),true));
-                    } else {
-                        nv.emplace_back(map_node(dm.at(i).at(j),false));
-                    }
-                }
-            }
-        }
-        // 2. Create edges
-        for(unsigned i=1; i<dm.size(); ++i) {
-            unsigned orig_nd_indice = 0, dest_nd_indice = 0;
-            for(unsigned k=0; k<nv.size(); ++k) {
-                if(nv.at(k).name.compare(dm.at(i).at(0)) == 0) {
-                    orig_nd_indice = k;
-                }
-                if(nv.at(k).name.compare(dm.at(i).at(1)) == 0) {
-                    dest_nd_indice = k;
-                }
-            }
-            nv.at(orig_nd_indice).edges.emplace_back(&nv.at(dest_nd_indice));
-            nv.at(orig_nd_indice).edges_costs.push_back(get_durations(i,dm));
+    unsigned get_node_id(const std::string &name, map_graph &g) const {
+        unsigned id = 0;
+        if(!g.find_node_id(name,id)) {
+            id = g.add_node(name,name.compare(terminal_location) == 0);
         }
+        return id;
     }
 };
 
@@ -0,0 +1,67 @@
+#ifndef MAP_FILE_HPP_
+#define MAP_FILE_HPP_
+
+#include <cstdint>
+
+/**
+ * @brief Binary map file header
+ *
+ * A binary map file is made of this header followed by the sections below, each one
+ * starting at the given byte offset from the beginning of the file, aligned on
+ * MAP_FILE_ALIGNMENT bytes:
+ * - names: concatenated node names, ordered by node id;
+ * - name offsets: nb_nodes + 1 uint32, node i is named names[name_offsets[i]] to
+ * names[name_offsets[i+1]-1];
+ * - offsets: nb_nodes + 1 uint32, CSR offsets of the outgoing edges of each node;
+ * - successors: nb_edges uint32, node reached through each edge;
+ * - time scale: nb_time_steps double;
+ * - durations: nb_edges * nb_time_steps double, row-major [edge][time_step].
+ * Integers and doubles are stored in the native byte order of the machine.
+ */
+struct map_file_header {
+    char magic[8]; ///< MAP_FILE_MAGIC
+    uint32_t version; ///< MAP_FILE_VERSION
+    uint32_t nb_nodes; ///< Number of nodes
+    uint32_t nb_edges; ///< Number of edges
+    uint32_t nb_time_steps; ///< Number of time steps
+    uint64_t names_offset; ///< Byte offset of the names section
+    uint64_t name_offsets_offset; ///< Byte offset of the name offsets section
+    uint64_t offsets_offset; ///< Byte offset of the CSR offsets section
+    uint64_t successors_offset; ///< Byte offset of the successors section
+    uint64_t time_scale_offset; ///< Byte offset of the time scale section
+    uint64_t durations_offset; ///< Byte offset of the durations section
+    uint64_t file_size; ///< Total size of the file in bytes
+};
+
+constexpr char MAP_FILE_MAGIC[8] = {'T','R','V','L','M','A','P','\0'};
+constexpr uint32_t MAP_FILE_VERSION = 1;
+constexpr uint64_t MAP_FILE_ALIGNMENT = 64;
+
+static_assert(sizeof(unsigned) == sizeof(uint32_t),"binary map files store unsigned as uint32");
+
+/**
+ * @brief Align a byte offset on MAP_FILE_ALIGNMENT
+ */
+inline uint64_t map_file_align(uint64_t offset) {
+    return (offset + MAP_FILE_ALIGNMENT - 1) / MAP_FILE_ALIGNMENT * MAP_FILE_ALIGNMENT;
+}
+
+/**
+ * @brief Is a map file section valid
+ *
+ * Test whether a section of nb_elements elements of element_size bytes starting at the
+ * given offset is aligned for its elements and lies within a file of file_size bytes, the
+ * bounds being computed without overflow.
+ */
+inline bool is_map_file_section_valid(
+    uint64_t offset,
+    uint64_t nb_elements,
+    uint64_t element_size,
+    uint64_t file_size)
+{
+    return offset % element_size == 0
+        && offset <= file_size
+        && nb_elements <= (file_size - offset) / element_size;
+}
+
+#endif // MAP_FILE_HPP_
@@ -0,0 +1,360 @@
+#ifndef MAP_GRAPH_HPP_
+#define MAP_GRAPH_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include <map_node.hpp>
+#include <mapped_file.hpp>
+#include <utils.hpp>
+
+/** @brief Number of edges whose durations are cached by each thread for procedural maps */
+constexpr unsigned PROCEDURAL_CACHE_SIZE = 64;
+
+/**
+ * @brief Procedural cache entry
+ *
+ * Durations of an edge of a procedural map, cached by a thread.
+ */
+struct procedural_cache_entry {
+    uint64_t graph_uid; ///< Unique identifier of the graph, 0 for an empty entry
+    unsigned edge; ///< Indice of the edge
+    std::vector<double> durations; ///< Durations of the edge at each time step
+};
+
+/**
+ * @brief Map graph class
+ *
+ * Graph stored in a compressed sparse row (CSR) layout.
+ * The outgoing edges of node i are the edges offsets[i] to offsets[i+1]-1, edge e leads to
+ * node successors[e] and its durations at each time step are stored contiguously from
+ * durations[e * nb_time_steps].
+ * Optionally, the (slope, intercept) of the linear interpolation of the durations are
+ * precomputed for each edge and each time interval.
+ * Node names are interned in a hash table mapping each name to the node id.
+ * The CSR arrays are views either on storage vectors owned by the graph or on a
+ * memory-mapped binary map file.
+ * The durations may also be procedural: they are not stored but regenerated on demand by a
+ * duration generator, the last durations generated by each thread being cached.
+ * @warning Nodes keep a pointer to the graph, hence the graph is neither copied nor moved.
+ */
+class map_graph {
+public:
+    std::unordered_map<std::string,unsigned> name_table; ///< Node id of each name
+    std::vector<map_node> nodes_vector; ///< Nodes, indexed by id
+    std::vector<double> time_scale; ///< Time of each time step
+    const unsigned * offsets; ///< Indice of the first outgoing edge of each node
+    const unsigned * successors; ///< Indice of the node reached through each edge
+    const double * durations; ///< Row-major duration tensor [edge][time_step]
+    unsigned nb_edges; ///< Number of edges
+    std::vector<double> segments; ///< Row-major (slope, intercept) tensor [edge][interval]
+    bool is_time_scale_uniform; ///< Are the time steps evenly spaced
+    double time_steps_width; ///< Width of the time steps if the time scale is uniform
+
+    std::vector<unsigned> offsets_storage; ///< Storage of the offsets if not memory-mapped
+    std::vector<unsigned> successors_storage; ///< Storage of the successors if not memory-mapped
+    std::vector<double> durations_storage; ///< Storage of the durations if not memory-mapped
+    std::unique_ptr<mapped_file> file; ///< Memory-mapped map file holding the CSR arrays
+    std::function<void(unsigned,double *)> duration_generator; ///< Writes the durations of an edge if they are procedural
+    const uint64_t uid; ///< Unique identifier of the graph, keys the procedural caches
+
+    map_graph() :
+        offsets(nullptr),
+        successors(nullptr),
+        durations(nullptr),
+        nb_edges(0),
+        is_time_scale_uniform(false),
+        time_steps_width(0.),
+        uid(get_new_uid())
+    {}
+
+    map_graph(const map_graph &) = delete;
+    map_graph & operator=(const map_graph &) = delete;
+
+    /**
+     * @brief Get new unique identifier
+     */
+    static uint64_t get_new_uid() {
+        static std::atomic<uint64_t> counter(0);
+        return ++counter;
+    }
+
+    /**
+     * @brief Add node
+     *
+     * The name of the node must not already be used.
+     * @return Return the id of the created node.
+     */
+    unsigned add_node(const std::string &name, bool is_goal) {
+        unsigned id = nodes_vector.size();
+        auto it = name_table.emplace(name,id).first;
+        assert(it->second == id);
+        nodes_vector.emplace_back(it->first,is_goal,id,this);
+        return id;
+    }
+
+    /**
+     * @brief Find node id
+     *
+     * @param {const std::string &} name; name of the node
+     * @param {unsigned &} id; modified to the id of the node if it exists
+     * @return Return true if a node with the given name exists.
+     */
+    bool find_node_id(const std::string &name, unsigned &id) const {
+        auto it = name_table.find(name);
+        if(it == name_table.end()) {
+            return false;
+        } else {
+            id = it->second;
+            return true;
+        }
+    }
+
+    unsigned get_nb_nodes() const {
+        return nodes_vector.size();
+    }
+
+    unsigned get_nb_edges() const {
+        return nb_edges;
+    }
+
+    unsigned get_nb_time_steps() const {
+        return time_scale.size();
+    }
+
+    /**
+     * @brief Get number of outgoing edges of a node
+     */
+    unsigned get_nb_edges(unsigned nd) const {
+        return offsets[nd+1] - offsets[nd];
+    }
+
+    /**
+     * @brief Get maximum number of outgoing edges
+     *
+     * @return Return the maximum number of outgoing edges of a node, 0 if there is none.
+     */
+    unsigned get_max_nb_edges() const {
+        unsigned max_nb_edges = 0;
+        for(unsigned nd=0; nd<get_nb_nodes(); ++nd) {
+            max_nb_edges = std::max(max_nb_edges,get_nb_edges(nd));
+        }
+        return max_nb_edges;
+    }
+
+    /**
+     * @brief Get edge indice
+     *
+     * @param {unsigned} nd; origin node id
+     * @param {unsigned} k; indice of the edge amongst the outgoing edges of the node
+     * @return Return the global indice of the edge.
+     */
+    unsigned get_edge_indice(unsigned nd, unsigned k) const {
+        return offsets[nd] + k;
+    }
+
+    /**
+     * @brief Get successor
+     *
+     * @param {unsigned} nd; origin node id
+     * @param {unsigned} k; indice of the edge amongst the outgoing edges of the node
+     * @return Return a pointer to the node reached through the edge.
+     */
+    const map_node * get_successor(unsigned nd, unsigned k) const {
+        return &nodes_vector[successors[offsets[nd] + k]];
+    }
+
+    /**
+     * @brief Are durations procedural
+     */
+    bool are_durations_procedural() const {
+        return static_cast<bool>(duration_generator);
+    }
+
+    /**
+     * @brief Get edge durations
+     *
+     * The durations of a procedural map are generated in the cache of the calling thread,
+     * unless they are already there.
+     * @return Return a pointer to the first of the nb_time_steps durations of the edge.
+     * @warning For a procedural map, the pointer is valid until the thread gets the
+     * durations of another edge.
+     */
+    const double * get_edge_durations(unsigned e) const {
+        if(!are_durations_procedural()) {
+            return &durations[(size_t) e * get_nb_time_steps()];
+        }
+        static thread_local std::array<procedural_cache_entry,PROCEDURAL_CACHE_SIZE> cache;
+        procedural_cache_entry &entry = cache[e % PROCEDURAL_CACHE_SIZE];
+        if(entry.graph_uid != uid || entry.edge != e) {
+            entry.durations.resize(get_nb_time_steps());
+            duration_generator(e,entry.durations.data());
+            entry.graph_uid = uid;
+            entry.edge = e;
+        }
+        return entry.durations.data();
+    }
+
+    /**
+     * @brief Are segments precomputed
+     */
+    bool are_segments_precomputed() const {
+        return segments.size() > 0;
+    }
+
+    /**
+     * @brief Get segment indice
+     *
+     * Get the indice of the time interval used to interpolate the durations at the input
+     * time. Times outside of the time scale use the first or the last interval.
+     * The indice is computed arithmetically if the time scale is uniform and with a binary
+     * search otherwise.
+     */
+    unsigned get_segment_indice(double t) const {
+        unsigned nb_intervals = get_nb_time_steps() - 1;
+        double x = 0.;
+        if(is_time_scale_uniform) {
+            x = (t - time_scale[0]) / time_steps_width;
+        } else {
+            x = (double) (std::upper_bound(time_scale.begin(),time_scale.end(),t) - time_scale.begin()) - 1.;
+        }
+        if(x < 1.) {
+            return 0;
+        } else if(x >= (double) nb_intervals) {
+            return nb_intervals - 1;
+        } else {
+            return (unsigned) x;
+        }
+    }
+
+    /**
+     * @brief Get edge segments
+     *
+     * @return Return a pointer to the first of the (slope, intercept) pairs of the edge.
+     */
+    const double * get_edge_segments(unsigned e) const {
+        return &segments[(size_t) 2 * e * (get_nb_time_steps() - 1)];
+    }
+
+    /**
+     * @brief Compute segments
+     *
+     * Precompute the (slope, intercept) of the linear interpolation of the durations of
+     * each edge on each time interval and check whether the time scale is uniform.
+     * Nothing is precomputed if the time scale has less than two time steps or if the
+     * durations are procedural, since the segments would take twice their memory.
+     */
+    void compute_segments() {
+        unsigned nb_time_steps = get_nb_time_steps();
+        if(nb_time_steps < 2 || are_durations_procedural()) {
+            return;
+        }
+        time_steps_width = time_scale[1] - time_scale[0];
+        is_time_scale_uniform = is_greater_than(time_steps_width,0.);
+        for(unsigned i=2; i<nb_time_steps && is_time_scale_uniform; ++i) {
+            double t = time_scale[0] + (double) i * time_steps_width;
+            is_time_scale_uniform = are_equal(time_scale[i],t);
+        }
+        unsigned nb_intervals = nb_time_steps - 1;
+        segments.resize((size_t) 2 * get_nb_edges() * nb_intervals);
+        for(unsigned e=0; e<get_nb_edges(); ++e) {
+            const double * c = get_edge_durations(e);
+            double * sg = &segments[(size_t) 2 * e * nb_intervals];
+            for(unsigned k=0; k<nb_intervals; ++k) {
+                double c_m = c[k], c_p = c[k+1];
+                double t_m = time_scale[k], t_p = time_scale[k+1];
+                sg[2*k] = (c_p - c_m) / (t_p - t_m);
+                sg[2*k+1] = (c_m * t_p - c_p * t_m) / (t_p - t_m);
+            }
+        }
+    }
+
+    /**
+     * @brief Set views
+     *
+     * Point the CSR arrays to external memory, e.g. a memory-mapped map file.
+     */
+    void set_views(
+        const unsigned * _offsets,
+        const unsigned * _successors,
+        const double * _durations,
+        unsigned _nb_edges)
+    {
+        offsets = _offsets;
+        successors = _successors;
+        durations = _durations;
+        nb_edges = _nb_edges;
+    }
+
+    /**
+     * @brief Set adjacency
+     *
+     * Build the CSR offsets and successors, stored in the graph, from a list of edges given
+     * in any order, and allocate the duration tensor unless the durations are procedural.
+     * The relative order of the edges sharing the same origin is preserved.
+     * @param {const std::vector<unsigned> &} origins; origin node id of each edge
+     * @param {const std::vector<unsigned> &} destinations; destination node id of each edge
+     * @return Return the indice in the CSR layout of each input edge.
+     */
+    std::vector<unsigned> set_adjacency(
+        const std::vector<unsigned> &origins,
+        const std::vector<unsigned> &destinations)
+    {
+        unsigned nb_rows = origins.size();
+        assert(destinations.size() == nb_rows);
+        offsets_storage.assign(get_nb_nodes() + 1,0);
+        for(unsigned e=0; e<nb_rows; ++e) {
+            ++offsets_storage[origins[e] + 1];
+        }
+        for(unsigned i=0; i<get_nb_nodes(); ++i) {
+            offsets_storage[i+1] += offsets_storage[i];
+        }
+        std::vector<unsigned> cursor(offsets_storage.begin(),offsets_storage.end() - 1);
+        std::vector<unsigned> positions(nb_rows);
+        successors_storage.resize(nb_rows);
+        for(unsigned e=0; e<nb_rows; ++e) {
+            positions[e] = cursor[origins[e]]++;
+            successors_storage[positions[e]] = destinations[e];
+        }
+        if(!are_durations_procedural()) {
+            durations_storage.resize((size_t) nb_rows * get_nb_time_steps());
+        }
+        set_views(
+            offsets_storage.data(),
+            successors_storage.data(),
+            durations_storage.data(),
+            nb_rows
+        );
+        return positions;
+    }
+
+    /**
+     * @brief Set edges
+     *
+     * Build the CSR layout, stored in the graph, from a list of edges given in any order.
+     * See set_adjacency.
+     * @param {const std::vector<double> &} edges_durations; row-major durations of each edge
+     * in the same order as the origins
+     */
+    void set_edges(
+        const std::vector<unsigned> &origins,
+        const std::vector<unsigned> &destinations,
+        const std::vector<double> &edges_durations)
+    {
+        unsigned nb_time_steps = get_nb_time_steps();
+        assert(edges_durations.size() == (size_t) origins.size() * nb_time_steps);
+        std::vector<unsigned> positions = set_adjacency(origins,destinations);
+        for(unsigned e=0; e<positions.size(); ++e) {
+            std::copy(
+                edges_durations.begin() + (size_t) e * nb_time_steps,
+                edges_durations.begin() + (size_t) (e + 1) * nb_time_steps,
+                durations_storage.begin() + (size_t) positions[e] * nb_time_steps
+            );
+        }
+    }
+};
+
+#endif // MAP_GRAPH_HPP_
@@ -1,27 +1,31 @@
 #ifndef MAP_NODE_HPP_
 #define MAP_NODE_HPP_
 
+class map_graph; // forward declaration
+
 class map_node {
 public:
-    const std::string name;
+    const std::string &name; ///< Interned name, owned by the graph's name table
     const bool is_goal;
-
-    std::vector<map_node*> edges;
-    std::vector<std::vector<double>> edges_costs;
+    const unsigned id; ///< Indice of the node in the graph
+    const map_graph * graph_ptr; ///< Graph holding the edges of the node
 
     map_node(
         const std::string &_name,
-        bool _is_goal) :
+        bool _is_goal,
+        unsigned _id,
+        const map_graph * _graph_ptr) :
         name(_name),
-        is_goal(_is_goal)
+        is_goal(_is_goal),
+        id(_id),
+        graph_ptr(_graph_ptr)
     {}
 
     void print() const {
         std::cout << "Map node - ";
         std::cout << "name: " << name << "; ";
-        std::cout << "nbedges: " << edges.size() << "; ";
+        std::cout << "id: " << id << "; ";
         std::cout << "terminal: " << is_goal << "\n";
-        assert(edges.size() == edges_costs.size());
     }
 };
 
@@ -12,6 +12,39 @@ struct duration_matrix_file_exception : std::exception {
     }
 };
 
+/**
+ * @brief Wrong duration matrix format
+ */
+struct duration_matrix_format_exception : std::exception {
+    explicit duration_matrix_format_exception() noexcept {}
+    virtual ~duration_matrix_format_exception() noexcept {}
+    virtual const char * what() const noexcept override {
+        return "in duration matrix: a line does not match the time scale or is not numeric.\n";
+    }
+};
+
+/**
+ * @brief Time scale too short
+ */
+struct time_scale_exception : std::exception {
+    explicit time_scale_exception() noexcept {}
+    virtual ~time_scale_exception() noexcept {}
+    virtual const char * what() const noexcept override {
+        return "in map: the time scale must have at least two time steps to interpolate the durations.\n";
+    }
+};
+
+/**
+ * @brief Wrong binary map file
+ */
+struct map_file_exception : std::exception {
+    explicit map_file_exception() noexcept {}
+    virtual ~map_file_exception() noexcept {}
+    virtual const char * what() const noexcept override {
+        return "in binary map file: wrong format, version or size.\n";
+    }
+};
+
 /**
  * @brief Illegal action
  */
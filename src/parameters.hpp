@@ -41,6 +41,7 @@ public:
     double DURATION_MIN;
     double DURATION_MAX;
     double LIP;
+    bool PROCEDURAL_DURATIONS;
     bool SAVE_DURATION_MATRIX;
     std::string OUTPUT_DURATION_MATRIX;
 
@@ -48,6 +49,11 @@ public:
     std::string TERMINAL_LOCATION;
     std::string INPUT_DURATION_MATRIX;
     std::string CSV_SEP;
+    unsigned INPUT_MAP_FORMAT;
+    unsigned OUTPUT_MAP_FORMAT;
+    bool PRECOMPUTE_SEGMENTS;
+    unsigned NB_THREADS;
+    unsigned MAP_SEED;
 
     // Policy parameters
     unsigned POLICY_SELECTOR;
@@ -56,6 +62,18 @@ public:
     double UCT_PARAMETER;
     unsigned TREE_SEARCH_BUDGET;
     unsigned DEFAULT_POLICY_HORIZON;
+    unsigned NB_ROLLOUTS_PER_LEAF;
+    bool REUSE_TREE;
+    unsigned NB_SEARCH_THREADS;
+    bool TREE_PARALLEL_SEARCH;
+    double VIRTUAL_LOSS;
+    double TIME_QUANTUM;
+    double WIDENING_COEFFICIENT;
+    double WIDENING_EXPONENT;
+    bool SHARE_TRANSPOSITIONS;
+    double TREE_MEMORY_LIMIT;
+    unsigned TREE_SEARCH_TIME_LIMIT;
+    unsigned TREE_SEARCH_CALLS_LIMIT;
     double REGRESSION_REGULARIZATION;
     unsigned POLYNOMIAL_REGRESSION_DEGREE;
 
@@ -90,18 +108,36 @@ public:
         && cfg.lookupValue("duration_min",DURATION_MIN)
         && cfg.lookupValue("duration_max",DURATION_MAX)
         && cfg.lookupValue("lip",LIP)
+        && cfg.lookupValue("procedural_durations",PROCEDURAL_DURATIONS)
         && cfg.lookupValue("save_duration_matrix",SAVE_DURATION_MATRIX)
         && cfg.lookupValue("output_duration_matrix",OUTPUT_DURATION_MATRIX)
         && cfg.lookupValue("initial_location",INITIAL_LOCATION)
         && cfg.lookupValue("terminal_location",TERMINAL_LOCATION)
         && cfg.lookupValue("input_duration_matrix",INPUT_DURATION_MATRIX)
         && cfg.lookupValue("csv_sep",CSV_SEP)
+        && cfg.lookupValue("input_map_format",INPUT_MAP_FORMAT)
+        && cfg.lookupValue("output_map_format",OUTPUT_MAP_FORMAT)
+        && cfg.lookupValue("precompute_segments",PRECOMPUTE_SEGMENTS)
+        && cfg.lookupValue("nb_threads",NB_THREADS)
+        && cfg.lookupValue("map_seed",MAP_SEED)
         && cfg.lookupValue("policy_selector",POLICY_SELECTOR)
         && cfg.lookupValue("is_model_dynamic",IS_MODEL_DYNAMIC)
         && cfg.lookupValue("discount_factor",DISCOUNT_FACTOR)
         && cfg.lookupValue("uct_parameter",UCT_PARAMETER)
         && cfg.lookupValue("tree_search_budget",TREE_SEARCH_BUDGET)
         && cfg.lookupValue("default_policy_horizon",DEFAULT_POLICY_HORIZON)
+        && cfg.lookupValue("nb_rollouts_per_leaf",NB_ROLLOUTS_PER_LEAF)
+        && cfg.lookupValue("reuse_tree",REUSE_TREE)
+        && cfg.lookupValue("nb_search_threads",NB_SEARCH_THREADS)
+        && cfg.lookupValue("tree_parallel_search",TREE_PARALLEL_SEARCH)
+        && cfg.lookupValue("virtual_loss",VIRTUAL_LOSS)
+        && cfg.lookupValue("time_quantum",TIME_QUANTUM)
+        && cfg.lookupValue("widening_coefficient",WIDENING_COEFFICIENT)
+        && cfg.lookupValue("widening_exponent",WIDENING_EXPONENT)
+        && cfg.lookupValue("share_transpositions",SHARE_TRANSPOSITIONS)
+        && cfg.lookupValue("tree_memory_limit",TREE_MEMORY_LIMIT)
+        && cfg.lookupValue("tree_search_time_limit",TREE_SEARCH_TIME_LIMIT)
+        && cfg.lookupValue("tree_search_calls_limit",TREE_SEARCH_CALLS_LIMIT)
         && cfg.lookupValue("regression_regularization",REGRESSION_REGULARIZATION)
         && cfg.lookupValue("polynomial_regression_degree",POLYNOMIAL_REGRESSION_DEGREE)) {
             /* Nothing to do */
@@ -109,6 +145,10 @@ public:
         else { // Error in config file
             throw wrong_syntax_configuration_file_exception();
         }
+        if(TREE_PARALLEL_SEARCH && (POLICY_SELECTOR == 1 || POLICY_SELECTOR == 2)
+        && (REUSE_TREE || WIDENING_COEFFICIENT > 0. || SHARE_TRANSPOSITIONS || TREE_MEMORY_LIMIT > 0.)) {
+            throw wrong_syntax_configuration_file_exception(); // not implemented with a shared tree
+        }
     }
 
     /**
@@ -143,7 +183,11 @@ public:
                 return std::unique_ptr<policy> (
                     new mcts_policy(
                         &en, IS_MODEL_DYNAMIC, DISCOUNT_FACTOR, UCT_PARAMETER,
-                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, 0
+                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, NB_ROLLOUTS_PER_LEAF, 0,
+                        REUSE_TREE, NB_SEARCH_THREADS, TREE_PARALLEL_SEARCH, VIRTUAL_LOSS,
+                        TREE_SEARCH_TIME_LIMIT, TREE_SEARCH_CALLS_LIMIT,
+                        TIME_QUANTUM, WIDENING_COEFFICIENT, WIDENING_EXPONENT, SHARE_TRANSPOSITIONS,
+                        TREE_MEMORY_LIMIT
                     )
                 );
             }
@@ -151,7 +195,11 @@ public:
                 return std::unique_ptr<policy> (
                     new mcts_policy(
                         &en, IS_MODEL_DYNAMIC, DISCOUNT_FACTOR, UCT_PARAMETER,
-                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, 1
+                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, NB_ROLLOUTS_PER_LEAF, 1,
+                        REUSE_TREE, NB_SEARCH_THREADS, TREE_PARALLEL_SEARCH, VIRTUAL_LOSS,
+                        TREE_SEARCH_TIME_LIMIT, TREE_SEARCH_CALLS_LIMIT,
+                        TIME_QUANTUM, WIDENING_COEFFICIENT, WIDENING_EXPONENT, SHARE_TRANSPOSITIONS,
+                        TREE_MEMORY_LIMIT
                     )
                 );
             }
@@ -159,8 +207,11 @@ public:
                 return std::unique_ptr<policy> (
                     new tmp_mcts_policy(
                         &en, IS_MODEL_DYNAMIC, DISCOUNT_FACTOR, UCT_PARAMETER,
-                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, 0,
-                        REGRESSION_REGULARIZATION, POLYNOMIAL_REGRESSION_DEGREE
+                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, NB_ROLLOUTS_PER_LEAF, 0,
+                        REGRESSION_REGULARIZATION, POLYNOMIAL_REGRESSION_DEGREE,
+                        REUSE_TREE, NB_SEARCH_THREADS, TREE_SEARCH_TIME_LIMIT, TREE_SEARCH_CALLS_LIMIT,
+                        TIME_QUANTUM, WIDENING_COEFFICIENT, WIDENING_EXPONENT, SHARE_TRANSPOSITIONS,
+                        TREE_MEMORY_LIMIT
                     )
                 );
             }
@@ -168,8 +219,11 @@ public:
                 return std::unique_ptr<policy> (
                     new tmp_mcts_policy(
                         &en, IS_MODEL_DYNAMIC, DISCOUNT_FACTOR, UCT_PARAMETER,
-                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, 1,
-                        REGRESSION_REGULARIZATION, POLYNOMIAL_REGRESSION_DEGREE
+                        TREE_SEARCH_BUDGET, DEFAULT_POLICY_HORIZON, NB_ROLLOUTS_PER_LEAF, 1,
+                        REGRESSION_REGULARIZATION, POLYNOMIAL_REGRESSION_DEGREE,
+                        REUSE_TREE, NB_SEARCH_THREADS, TREE_SEARCH_TIME_LIMIT, TREE_SEARCH_CALLS_LIMIT,
+                        TIME_QUANTUM, WIDENING_COEFFICIENT, WIDENING_EXPONENT, SHARE_TRANSPOSITIONS,
+                        TREE_MEMORY_LIMIT
                     )
                 );
             }
@@ -185,7 +239,11 @@ public:
      * Build the environment according to the parameters of the configuration file.
      * If GENERATE_MAP is true, a map is generated.
      * If SAVE_DURATION_MATRIX is true, the map is saved at the given output path.
-     * If GENERATE_MAP is false, the map at the given input path is used.
+     * If GENERATE_MAP is false, the map at the given input path is used; it is saved in the
+     * output format, hence converted, if SAVE_DURATION_MATRIX is true and if the input and
+     * output formats differ.
+     * If PRECOMPUTE_SEGMENTS is true, the interpolation coefficients of the durations are
+     * computed once for all.
      */
     environment build_environment() const {
         map_builder mb(
@@ -199,40 +257,54 @@ public:
             DURATION_MIN,
             DURATION_MAX,
             LIP,
+            PROCEDURAL_DURATIONS,
             INITIAL_LOCATION,
             TERMINAL_LOCATION,
             INPUT_DURATION_MATRIX,
-            CSV_SEP
+            CSV_SEP,
+            NB_THREADS,
+            (MAP_SEED == 0) ? std::random_device()() : MAP_SEED
         );
-        std::vector<std::vector<std::string>> dm;
+        std::unique_ptr<map_graph> g(new map_graph());
         if(GENERATE_MAP) {
             switch(GRAPH_TYPE_SELECTOR) {
                 case 0: {
-                    dm = mb.build_connected_directed_duration_matrix();
+                    mb.build_connected_directed_duration_matrix(*g);
                     break;
                 }
                 case 1: {
-                    dm = mb.build_connected_symmetric_directed_duration_matrix();
+                    mb.build_connected_symmetric_directed_duration_matrix(*g);
                     break;
                 }
                 case 2: {
-                    dm = mb.build_sequential_duration_matrix();
+                    mb.build_sequential_duration_matrix(*g);
                     break;
                 }
                 default: {
-                    dm = mb.build_connected_directed_duration_matrix();
+                    mb.build_connected_directed_duration_matrix(*g);
                 }
             }
             if(SAVE_DURATION_MATRIX) {
-                mb.save_duration_matrix(dm,OUTPUT_DURATION_MATRIX);
+                mb.save_duration_matrix(*g,OUTPUT_DURATION_MATRIX,OUTPUT_MAP_FORMAT);
             }
         } else {
-            dm = mb.extract_duration_matrix();
+            switch(INPUT_MAP_FORMAT) {
+                case 1: {
+                    mb.open_binary_duration_matrix(*g);
+                    break;
+                }
+                default: {
+                    mb.load_csv_duration_matrix(*g);
+                }
+            }
+            if(SAVE_DURATION_MATRIX && (INPUT_MAP_FORMAT != OUTPUT_MAP_FORMAT)) {
+                mb.save_duration_matrix(*g,OUTPUT_DURATION_MATRIX,OUTPUT_MAP_FORMAT);
+            }
+        }
+        if(PRECOMPUTE_SEGMENTS) {
+            g->compute_segments();
         }
-        std::vector<double> ts;
-        std::vector<map_node> nv;
-        mb.build_time_scale_and_map_from_duration_matrix(dm,ts,nv);
-        return environment(REWARD_SCALING_MAX,GOAL_REWARD,DEAD_END_REWARD,ts,nv);
+        return environment(REWARD_SCALING_MAX,GOAL_REWARD,DEAD_END_REWARD,g);
     }
 };
 
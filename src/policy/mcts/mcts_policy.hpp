@@ -1,48 +1,113 @@
 #ifndef MCTS_POLICY_HPP_
 #define MCTS_POLICY_HPP_
 
-#include <cnode.hpp>
-#include <dnode.hpp>
+#include <chrono>
+
 #include <environment.hpp>
+#include <mcts_tree.hpp>
+#include <parallel.hpp>
 #include <random_policy.hpp>
+#include <shared_mcts_tree.hpp>
+#include <uct_selection.hpp>
 #include <utils.hpp>
 
 class mcts_policy : public policy {
 public:
-    random_policy default_policy; ///< Default policy
     const environment * envt_ptr; ///< Generative model (pointer to the real environment)
     const bool is_model_dynamic; ///< Is the model dynamic
     const double discount_factor; ///< Discount factor
     const double uct_parameter; ///< UCT parameter
     const unsigned budget; ///< Budget ie number of expanded nodes in the tree
     const unsigned horizon; ///< Horizon for the default policy simulation
+    const unsigned nb_rollouts; ///< Number of default policy simulations at each evaluated leaf, averaged to lower the variance of its value
     const unsigned mcts_strategy_switch; ///< Strategy switch for MCTS algorithm
+    const bool reuse_tree; ///< Keep the subtree of the observed successor state between applications
+    const unsigned nb_search_threads; ///< Number of threads of the search
+    const bool tree_parallel; ///< Share a single tree between the search threads instead of building one tree per thread
+    const double virtual_loss; ///< Return counted for an ongoing visit of the shared tree
+    const unsigned time_limit; ///< Per-decision time limit of the search in microseconds, 0 for none
+    const unsigned calls_limit; ///< Per-decision limit on the generative model calls of each search thread, 0 for none
+    const double time_quantum; ///< Width of the time buckets merging the successor states of a chance node, 0 for exact times
+    const double widening_coefficient; ///< Progressive widening coefficient k, a chance node visited n times having at most k * n^alpha successors, 0 for none
+    const double widening_exponent; ///< Progressive widening exponent alpha
+    const bool share_transpositions; ///< Share the decision nodes with the same map node and time bucket between the paths of the tree
+    const size_t tree_memory_limit; ///< Limit on the bytes allocated by the tree of each search thread, pruned before it outgrows them, 0 for none
 
     double reference_time; ///< Initial time of the state at which the policy is applied
     unsigned nb_calls; ///< Number of calls to the generative model
     unsigned nb_cnodes; ///< Number of expanded chance nodes
+    unsigned nb_iterations; ///< Number of iterations of the last search of the thread
+    size_t peak_tree_bytes; ///< Peak number of bytes of the tree during the last search of the thread
+    std::chrono::steady_clock::time_point deadline; ///< Deadline of the current search
+    decision_statistics last_decision; ///< Statistics of the last application of the policy
+    mcts_tree tree; ///< Search tree, rebuilt or re-rooted at each application of the policy
+    xoshiro_rng rng; ///< Random number generator of the search, reseeded at each application
+    std::vector<path_step> path; ///< Visited chance nodes of the current iteration, kept between iterations
+    std::vector<double> rollout_returns; ///< Returns of the rollouts of the evaluated leaf
+    uct_selection selection; ///< Children gathered by the UCT strategy, kept between selections
+    std::vector<std::unique_ptr<mcts_policy>> workers; ///< Policies building the trees of the other search threads
+    std::unique_ptr<shared_mcts_tree> shared_tree; ///< Tree shared by the search threads, allocated at the first application
 
     /**
      * @brief Constructor
      */
     mcts_policy(
-        environment * _envt_ptr,
+        const environment * _envt_ptr,
         bool _is_model_dynamic,
         double _discount_factor,
         double _uct_parameter,
         unsigned _budget,
         unsigned _horizon,
-        unsigned _mcts_strategy_switch) :
+        unsigned _nb_rollouts,
+        unsigned _mcts_strategy_switch,
+        bool _reuse_tree,
+        unsigned _nb_search_threads,
+        bool _tree_parallel,
+        double _virtual_loss,
+        unsigned _time_limit,
+        unsigned _calls_limit,
+        double _time_quantum,
+        double _widening_coefficient,
+        double _widening_exponent,
+        bool _share_transpositions,
+        double _tree_memory_limit) :
         envt_ptr(_envt_ptr),
         is_model_dynamic(_is_model_dynamic),
         discount_factor(_discount_factor),
         uct_parameter(_uct_parameter),
         budget(_budget),
         horizon(_horizon),
-        mcts_strategy_switch(_mcts_strategy_switch)
+        nb_rollouts(std::max(_nb_rollouts,1u)),
+        mcts_strategy_switch(_mcts_strategy_switch),
+        reuse_tree(_reuse_tree),
+        nb_search_threads(get_nb_threads(_nb_search_threads)),
+        tree_parallel(_tree_parallel),
+        virtual_loss(_virtual_loss),
+        time_limit(_time_limit),
+        calls_limit(_calls_limit),
+        time_quantum(_time_quantum),
+        widening_coefficient(_widening_coefficient),
+        widening_exponent(_widening_exponent),
+        share_transpositions(_share_transpositions),
+        tree_memory_limit((size_t) (_tree_memory_limit * 1e6)),
+        rng(0,0),
+        rollout_returns(nb_rollouts)
     {
         nb_calls = 0;
         nb_cnodes = 0;
+        nb_iterations = 0;
+        peak_tree_bytes = 0;
+        last_decision = decision_statistics{0.,0,0,0};
+        tree.time_quantum = time_quantum;
+        tree.share_transpositions = share_transpositions;
+        for(unsigned k=1; k<nb_search_threads; ++k) {
+            workers.emplace_back(new mcts_policy(
+                envt_ptr, is_model_dynamic, discount_factor, uct_parameter, budget, horizon,
+                nb_rollouts, mcts_strategy_switch, reuse_tree, 1, tree_parallel, virtual_loss,
+                time_limit, calls_limit, time_quantum, widening_coefficient, widening_exponent,
+                share_transpositions, _tree_memory_limit
+            ));
+        }
     }
 
     /**
@@ -70,40 +135,57 @@ public:
     /**
      * @brief Sample return
      *
-     * Sample a return with the default policy starting at the input state.
-     * @param {state} s; input state
+     * Sample a return with the default policy starting at the input state and action.
+     * The default policy being uniformly random, the simulation is run by the rollout kernel
+     * of the environment, each of its transitions counting as a generative model call.
+     * @param {const state &} s; input state
+     * @param {const action &} a; first action
      * @return Return the sampled return.
      */
-    double sample_return(cnode * ptr) {
-        if(envt_ptr->is_state_terminal(ptr->s)) {
-            return envt_ptr->get_terminal_reward(ptr->s);
+    double sample_return(const state &s, const action &a) {
+        if(envt_ptr->is_state_terminal(s)) {
+            return envt_ptr->get_terminal_reward(s);
         }
-        double total_return = 0.;
-        state s = ptr->s;
-        action a = ptr->a;
-        for(unsigned t=0; t<horizon; ++t) {
-            state s_p;
-            double r = 0.;
-            generative_model(s,a,r,s_p);
-            total_return += pow(discount_factor,(double)t) * r;
-            if(envt_ptr->is_state_terminal(s_p)) {
-                break;
-            }
-            s = s_p;
-            a = default_policy.apply(s);
+        return envt_ptr->rollout(
+            s.nd_ptr->id, s.t, a.indice, is_model_dynamic, reference_time, discount_factor,
+            horizon, rng, nb_calls
+        );
+    }
+
+    /**
+     * @brief Sample returns
+     *
+     * Sample nb_rollouts returns with the default policy starting at the input state and
+     * action, several rollouts being simulated as a batch, see environment::batch_rollout.
+     * @param {const state &} s; input state
+     * @param {const action &} a; first action
+     * @return Return the statistics of the sampled returns.
+     */
+    running_statistics sample_returns(const state &s, const action &a) {
+        running_statistics samples;
+        if(nb_rollouts == 1 || envt_ptr->is_state_terminal(s)) {
+            samples.add(sample_return(s,a));
+            return samples;
         }
-        return total_return;
+        envt_ptr->batch_rollout(
+            s.nd_ptr->id, s.t, a.indice, is_model_dynamic, reference_time, discount_factor,
+            horizon, rng, nb_rollouts, rollout_returns.data(), nb_calls
+        );
+        for(double q : rollout_returns) {
+            samples.add(q);
+        }
+        return samples;
     }
 
     /**
      * @brief Update value
      *
-     * Update the value of a chance node by stacking a new sampled value.
-     * @param {cnode *} ptr; pointer to the updated chance node
+     * Update the value of a chance node by adding a new sampled value to its statistics.
+     * @param {unsigned} c; updated chance node
      * @param {double} q; new sampled value
      */
-    void update_value(cnode * ptr, double q) const {
-        ptr->sampled_returns.push_back(q);
+    void update_value(unsigned c, double q) {
+        tree.c_returns[c].add(q);
     }
 
     /**
@@ -111,30 +193,11 @@ public:
      *
      * Select child of a decision node wrt the MCTS strategy.
      * The node must be fully expanded.
-     * @param {dnode *} v; decision node
+     * @param {unsigned} v; decision node
      * @return Return to the select child, which is a chance node.
      */
-    cnode * mcts_strategy(dnode * v) const {
-        return v->children.at(rand_indice(v->children)).get();
-    }
-
-    /**
-     * @brief UCT scores
-     *
-     * Compute the UCT scores of the given vector of chance nodes.
-     * @param {const std::vector<std::unique_ptr<cnode>> &} cv; input vector
-     * @return Return a vector containing the scores of the given vector of chance nodes.
-     */
-    std::vector<double> uct_scores(const std::vector<std::unique_ptr<cnode>> &cv) const {
-        std::vector<double> scores;
-        for(auto &c : cv) {
-            scores.emplace_back(
-                c->get_value()
-                + 2 * uct_parameter *
-                sqrt(log((double) nb_cnodes) / ((double) c->get_nb_visits()))
-            );
-        }
-        return scores;
+    unsigned mcts_strategy(unsigned v) {
+        return tree.get_child(v,uniform_integer(rng,0,tree.d_nb_children[v]-1));
     }
 
     /**
@@ -142,11 +205,12 @@ public:
      *
      * Select child of a decision node wrt the UCT strategy.
      * The node must be fully expanded.
-     * @param {dnode *} v; decision node
+     * @param {unsigned} v; decision node
      * @return Return to the select child, which is a chance node.
      */
-    cnode * uct_strategy(dnode * v) const {
-        return v->children.at(argmax(uct_scores(v->children))).get();
+    unsigned uct_strategy(unsigned v) {
+        gather_children(tree,v);
+        return selection.select(uct_parameter,(double) nb_cnodes,rng);
     }
 
     /**
@@ -154,10 +218,10 @@ public:
      *
      * Select child of a decision node wrt one of the implemented strategies.
      * The node must be fully expanded.
-     * @param {dnode *} v; decision node
+     * @param {unsigned} v; decision node
      * @return Return to the select child, which is a chance node.
      */
-    cnode * select_child(dnode * v) const {
+    unsigned select_child(unsigned v) {
         switch(mcts_strategy_switch) {
             case 0: { // Vanilla MCTS
                 return mcts_strategy(v);
@@ -174,142 +238,196 @@ public:
     /**
      * @brief Evaluate
      *
-     * Create a new child node to a decision node and sample a return value
-     * with the default policy.
-     * @param {dnode *} v; pointer to the decision node
-     * @return Return the sampled value.
+     * Create a new child node to a decision node and sample nb_rollouts return values
+     * with the default policy, all of them being added to the child's statistics.
+     * @param {unsigned} v; decision node
+     * @return Return the mean sampled value.
      */
-    double evaluate(dnode * v) {
+    double evaluate(unsigned v) {
         nb_cnodes++; // a chance node will be created
-        v->create_child();
-        double q = sample_return(v->children.back().get());
-        update_value(v->children.back().get(),q);
-        return q;
+        unsigned c = tree.expand(v,rng);
+        running_statistics samples = sample_returns(tree.get_state(v),tree.get_action(c));
+        tree.c_returns[c].merge(samples);
+        return samples.get_mean();
     }
 
     /**
-     * @brief Is state already sampled
+     * @brief Is widening capped
      *
-     * Equality operator.
-     * @param {cnode *} ptr; pointer to the chance node
-     * @param {state &} s; sampled state
-     * @param {unsigned &} ind; indice modified to the value of the indice of the existing
-     * decision node with state s if the comparison succeeds.
+     * Test whether progressive widening forbids a new successor below a chance node, ie
+     * whether it has at least k * n^alpha successors, n being its number of visits.
+     * @param {unsigned} c; chance node
      */
-    bool is_state_already_sampled(cnode * ptr, state &s, unsigned &ind) const {
-        for(unsigned i=0; i<ptr->children.size(); ++i) {
-            if(s.is_equal_to(ptr->children[i]->s)) {
-                ind = i;
-                return true;
-            }
-        }
-        return false;
+    bool is_widening_capped(unsigned c) const {
+        return widening_coefficient > 0.
+            && tree.c_first_child[c] != NO_NODE
+            && (double) tree.get_nb_successors(c)
+            >= widening_coefficient * pow((double) tree.get_nb_visits(c),widening_exponent);
     }
 
     /**
      * @brief Search tree
      *
      * Search within the tree, starting from the input decision node.
-     * Recursive method.
-     * @param {dnode *} v; input decision node
-     * @param {double} t_root; time reference of the root node
+     * The tree is descended down to a leaf node, which is evaluated, then the sampled
+     * returns are backpropagated along the visited chance nodes, stored in the path buffer.
+     * A chance node whose successors are capped by progressive widening is descended through
+     * one of its successors instead of sampling a transition.
+     * @param {unsigned} v; input decision node
      * @return Return the sampled return at the given decision node
      */
-    double search_tree(dnode * v) {
-        if(envt_ptr->is_state_terminal(v->s)) { // terminal node
-            return envt_ptr->get_terminal_reward(v->s);
-        } else if(!v->is_fully_expanded()) { // leaf node, expand it
-            return evaluate(v);
-        } else { // apply tree policy
-            cnode * cnp = select_child(v);
+    double search_tree(unsigned v) {
+        path.clear();
+        double q = 0.;
+        while(true) {
+            state s = tree.get_state(v);
+            if(envt_ptr->is_state_terminal(s)) { // terminal node
+                q = envt_ptr->get_terminal_reward(s);
+                break;
+            } else if(!tree.is_fully_expanded(v)) { // leaf node, expand it
+                q = evaluate(v);
+                break;
+            }
+            unsigned c = select_child(v); // apply tree policy
+            if(is_widening_capped(c)) { // revisit a successor instead of sampling one
+                v = tree.sample_successor(c,rng);
+                ++tree.d_nb_visits[v];
+                path.push_back(path_step{c,envt_ptr->reward_function(tree.get_state(v))});
+                continue;
+            }
             state s_p;
             double r = 0.;
-            generative_model(v->s,cnp->a,r,s_p);
-            double q = 0.;
-            unsigned ind = 0; // indice of resulting child
-            if(is_state_already_sampled(cnp,s_p,ind)) { // go to node
-                q = r + discount_factor * search_tree(cnp->children.at(ind).get());
-            } else { // leaf node, create a new node
-                cnp->children.emplace_back(std::unique_ptr<dnode>(
-                    new dnode(s_p,cnp->depth+1)
-                ));
-                q = r + discount_factor * evaluate(cnp->get_last_child());
+            generative_model(s,tree.get_action(c),r,s_p);
+            path.push_back(path_step{c,r});
+            v = tree.find_successor(v,c,s_p);
+            if(v == NO_NODE) { // leaf node, create a new node
+                q = evaluate(tree.add_dnode(s_p,c));
+                break;
             }
-            update_value(cnp,q);
-            return q;
+            ++tree.d_nb_visits[v];
         }
+        for(auto it = path.rbegin(); it != path.rend(); ++it) { // backpropagate
+            q = it->r + discount_factor * q;
+            update_value(it->c,q);
+        }
+        return q;
+    }
+
+    /**
+     * @brief Is search over
+     *
+     * Test whether the search of the thread must stop: either the budget is spent, the
+     * deadline is passed or the generative model was called too many times.
+     * @param {unsigned} first_call; number of calls to the generative model when the search
+     * started
+     */
+    bool is_search_over(unsigned first_call) const {
+        return nb_iterations >= budget
+            || (calls_limit > 0 && nb_calls - first_call >= calls_limit)
+            || (time_limit > 0 && std::chrono::steady_clock::now() >= deadline);
     }
 
     /**
      * @brief Build tree
      *
-     * Build a tree at the input node.
-     * @param {dnode &} v; reference to the input node
+     * Build a tree at the root node.
+     * At least one iteration is run so that the root has a child to recommend.
+     * If the tree has a memory limit, its arrays are reserved within the limit, see
+     * set_root, and before an iteration that could outgrow them the tree is pruned down to
+     * TREE_PRUNING_TARGET of its nodes; the search stops if it cannot be, the nodes that are
+     * never pruned filling the memory.
      */
-    void build_tree(dnode &v) {
-        for(unsigned i=0; i<budget; ++i) {
-            search_tree(&v);
-        }
+    void build_tree() {
+        unsigned first_call = nb_calls;
+        nb_iterations = 0;
+        peak_tree_bytes = tree.get_nb_bytes();
+        do {
+            if(tree_memory_limit > 0 && !tree.has_room() && !tree.prune(TREE_PRUNING_TARGET) && nb_iterations > 0) {
+                break;
+            }
+            search_tree(0);
+            ++nb_iterations;
+            peak_tree_bytes = std::max(peak_tree_bytes,tree.get_nb_bytes());
+        } while(!is_search_over(first_call));
         nb_cnodes = 0;
     }
 
     /**
-     * @brief Argmax value
+     * @brief Gather children
      *
-     * Get the indice of the child with the maximum value.
-     * @param {const dnode &} v; input decision node
-     * @return Return the indice of the child with the maximum value.
+     * Gather the children of a decision node into the selection, before selecting one of them.
+     * Template method, T being either mcts_tree or shared_mcts_tree.
+     * @param {const T &} t; tree
+     * @param {unsigned} v; input decision node
      */
-    unsigned argmax_value(const dnode &v) const {
-        std::vector<double> values;
-        for(auto &c: v.children) {
-            values.emplace_back(c->get_value());
+    template <class T>
+    void gather_children(const T &t, unsigned v) {
+        selection.clear();
+        for(unsigned c = t.get_first_child(v); c != NO_NODE; c = t.get_next_sibling(c)) {
+            selection.add(c,t.get_value(c),t.get_nb_visits(c));
         }
-        return argmax(values);
+    }
+
+    /**
+     * @brief Argmax value
+     *
+     * Get the child with the maximum value, ties being broken with the random number generator.
+     * Template method, see gather_children.
+     * @param {const T &} t; tree
+     * @param {unsigned} v; input decision node
+     * @return Return the chance node with the maximum value.
+     */
+    template <class T>
+    unsigned argmax_value(const T &t, unsigned v) {
+        gather_children(t,v);
+        return selection.select_greatest_value(rng);
     }
 
     /**
      * @brief Argmax visit counter
      *
-     * Get the indice of the child with the maximum number of visits.
-     * @param {const dnode &} v; input decision node
-     * @return Return the indice of the child with the maximum number of visits.
+     * Get the child with the maximum number of visits, ties being broken with the random
+     * number generator. Template method, see gather_children.
+     * @param {const T &} t; tree
+     * @param {unsigned} v; input decision node
+     * @return Return the chance node with the maximum number of visits.
      */
-    unsigned argmax_nb_visits(const dnode &v) const {
-        std::vector<unsigned> nb_visits;
-        for(auto &c: v.children) {
-            nb_visits.emplace_back(c->get_nb_visits());
-        }
-        return argmax(nb_visits);
+    template <class T>
+    unsigned argmax_nb_visits(const T &t, unsigned v) {
+        gather_children(t,v);
+        return selection.select_most_visited(rng);
     }
 
     /**
      * @brief Recommended action
      *
-     * Get the recommended action from an input decision node.
-     * @param {const dnode &} v; input decision node
+     * Get the recommended action from an input decision node of the tree of the policy or of
+     * the shared tree. Template method, see gather_children.
+     * @param {const T &} t; tree
+     * @param {unsigned} v; input decision node
      * @return Return the recommended action at the input decision node.
      */
-    action recommended_action(const dnode &v) {
-        //return v.children.at(argmax_nb_visits(v))->a; // higher number of visits
-        return v.children.at(argmax_value(v))->a; // higher value
+    template <class T>
+    action recommended_action(const T &t, unsigned v) {
+        //return t.get_action(argmax_nb_visits(t,v)); // higher number of visits
+        return t.get_action(argmax_value(t,v)); // higher value
     }
 
-    void print_tree(const dnode &v) const {
-        std::cout << "Root : " << v.s.get_name() << std::endl;
+    void print_tree(unsigned v) const {
+        std::cout << "Root : " << tree.get_state(v).get_name() << std::endl;
         std::cout << "d1   : ";
-        for(auto &cn_ch : v.children) {
-            for(auto &dn_ch : cn_ch->children) {
-                std::cout << dn_ch->s.get_name() << "(" << cn_ch->s.get_name() << ") ";
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            for(unsigned d = tree.c_first_child[c]; d != NO_NODE; d = tree.d_sibling[d]) {
+                std::cout << tree.get_state(d).get_name() << "(" << tree.get_state(v).get_name() << ") ";
             }
         }
         std::cout << std::endl;
         std::cout << "d2   : ";
-        for(auto &cn_ch : v.children) {
-            for(auto &dn_ch : cn_ch->children) {
-                for(auto &a : dn_ch->children) {
-                    for(auto &b : a->children) {
-                        std::cout << b->s.get_name() << "(" << a->s.get_name() << ") ";
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            for(unsigned d = tree.c_first_child[c]; d != NO_NODE; d = tree.d_sibling[d]) {
+                for(unsigned a = tree.d_first_child[d]; a != NO_NODE; a = tree.c_sibling[a]) {
+                    for(unsigned b = tree.c_first_child[a]; b != NO_NODE; b = tree.d_sibling[b]) {
+                        std::cout << tree.get_state(b).get_name() << "(" << tree.get_state(d).get_name() << ") ";
                     }
                 }
             }
@@ -317,13 +435,13 @@ public:
         std::cout << std::endl;
     }
 
-    void print_first_layer(const dnode &v) const {
+    void print_first_layer(unsigned v) const {
         std::cout << "\n----------------------------------------------------\n";
-        std::cout << "Root : " << v.s.get_name() << std::endl;
-        for(auto &cnp : v.children) {
-            std::cout << "    dir: " << cnp->a.direction << "  ";
-            std::cout << "nvis: " << cnp->get_nb_visits() << "  ";
-            std::cout << "val: "<< cnp->get_value() << "\n";
+        std::cout << "Root : " << tree.get_state(v).get_name() << std::endl;
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            std::cout << "    dir: " << tree.get_state(v).get_direction(tree.get_action(c)) << "  ";
+            std::cout << "nvis: " << tree.get_nb_visits(c) << "  ";
+            std::cout << "val: "<< tree.get_value(c) << "\n";
         }
     }
 
@@ -333,18 +451,20 @@ public:
         std::cout << "Initial state:\n";
         s.print();
         std::cout << "Edges: ";
-        for(auto &e : s.nd_ptr->edges) {
-            std::cout << e->name << " ";
+        for(unsigned k=0; k<s.get_nb_edges(); ++k) {
+            std::cout << s.get_ptr_to_successor(k)->name << " ";
         }
         std::cout << "\nCosts:\n";
-        for(auto &ec : s.nd_ptr->edges_costs) {
+        const map_graph &g = *envt_ptr->graph;
+        for(unsigned k=0; k<s.get_nb_edges(); ++k) {
+            const double * ec = g.get_edge_durations(g.get_edge_indice(s.nd_ptr->id,k));
             for(unsigned i=0; i<3; ++i) {
-                std::cout << ec.at(i) << " ";
+                std::cout << ec[i] << " ";
             }
             std::cout << std::endl;
         }
-        action a(s.nd_ptr->edges.at(2)->name);
-        std::cout << "Action: " << a.direction << std::endl;
+        action a(2);
+        std::cout << "Action: " << s.get_direction(a) << std::endl;
         state s_pdyn = s;
         state s_psta = s;
         double r = 0.;
@@ -357,16 +477,236 @@ public:
         exit(0);
     }
 
+    /**
+     * @brief Set root
+     *
+     * Set the root of the tree at the input state.
+     * The tree of the previous application is cleared and the new tree is built in the
+     * same memory, unless it is reused and was re-rooted at a decision node the input state
+     * is merged into, ie with its map node and time bucket; the root then keeps the time of
+     * the first state merged into it, as any merged node.
+     * If the tree has a memory limit, its arrays are reserved for as many nodes as fit in it.
+     */
+    void set_root(const state &s) {
+        reference_time = s.t;
+        if(tree_memory_limit > 0) {
+            tree.reserve_memory(tree_memory_limit,std::max(envt_ptr->graph->get_max_nb_edges(),1u));
+        }
+        if(!is_tree_reused() || tree.get_nb_dnodes() == 0 || !tree.is_merged_into(0,s)) {
+            tree.clear();
+            tree.add_dnode(s);
+        }
+        nb_cnodes = tree.get_nb_cnodes();
+    }
+
+    /**
+     * @brief Merge root statistics
+     *
+     * Merge the sampled returns statistics of the root's children of another tree into the
+     * ones of the tree, creating the children that do not exist yet.
+     * @param {const mcts_tree &} t; merged tree, with the same root
+     */
+    void merge_root_statistics(const mcts_tree &t) {
+        for(unsigned c = t.d_first_child[0]; c != NO_NODE; c = t.c_sibling[c]) {
+            unsigned m = tree.find_action(0,t.get_action(c));
+            if(m == NO_NODE) {
+                m = tree.expand_action(0,t.get_action(c));
+            }
+            tree.c_returns[m].merge(t.c_returns[c]);
+        }
+    }
+
+    /**
+     * @brief Select shared child
+     *
+     * Select child of a decision node of the shared tree wrt one of the implemented
+     * strategies, the ongoing visits counting in the UCT scores.
+     * The node must be fully expanded, hence its children do not change.
+     * @param {const shared_mcts_tree &} st; shared tree
+     * @param {unsigned} v; decision node
+     * @return Return to the select child, which is a chance node.
+     */
+    unsigned select_shared_child(const shared_mcts_tree &st, unsigned v) {
+        switch(mcts_strategy_switch) {
+            case 1: { // UCT
+                gather_children(st,v);
+                return selection.select(uct_parameter,(double) st.get_nb_cnodes(),rng);
+            }
+            default: { // Vanilla MCTS
+                return st.get_child(v,uniform_integer(rng,0,st.get_nb_children(v)-1));
+            }
+        }
+    }
+
+    /**
+     * @brief Search shared tree
+     *
+     * Search within the shared tree, starting from the input decision node, concurrently
+     * with the other search threads.
+     * A visited chance node holds a virtual loss until its sampled return is known.
+     * Each iteration creates at most one decision and one chance node, as the sequential
+     * search, hence the capacity of the tree is never exceeded.
+     * Same descent and backpropagation as search_tree.
+     * @param {shared_mcts_tree &} st; shared tree
+     * @param {unsigned} v; input decision node
+     * @return Return the sampled return at the given decision node
+     */
+    double search_shared_tree(shared_mcts_tree &st, unsigned v) {
+        path.clear();
+        double q = 0.;
+        while(true) {
+            state s = st.get_state(v);
+            if(envt_ptr->is_state_terminal(s)) { // terminal node
+                q = envt_ptr->get_terminal_reward(s);
+                break;
+            }
+            if(!st.is_fully_expanded(v)) { // leaf node, expand it unless another thread did
+                unsigned c = st.expand(v,rng,virtual_loss);
+                if(c != NO_NODE) {
+                    running_statistics samples = sample_returns(s,st.get_action(c));
+                    st.update_value(c,samples,virtual_loss);
+                    q = samples.get_mean();
+                    break;
+                }
+            }
+            unsigned c = select_shared_child(st,v); // apply tree policy
+            st.add_virtual_loss(c,virtual_loss);
+            state s_p;
+            double r = 0.;
+            generative_model(s,st.get_action(c),r,s_p);
+            path.push_back(path_step{c,r});
+            unsigned c_p = NO_NODE;
+            v = st.find_or_add_dnode(c,s_p,rng,virtual_loss,c_p);
+            if(c_p != NO_NODE) { // leaf node, created with a first child
+                running_statistics samples = sample_returns(s_p,st.get_action(c_p));
+                st.update_value(c_p,samples,virtual_loss);
+                q = samples.get_mean();
+                break;
+            }
+        }
+        for(auto it = path.rbegin(); it != path.rend(); ++it) { // backpropagate
+            q = it->r + discount_factor * q;
+            st.update_value(it->c,q,virtual_loss);
+        }
+        return q;
+    }
+
+    /**
+     * @brief Build shared tree
+     *
+     * Run the iterations of the thread in the shared tree, see build_tree.
+     */
+    void build_shared_tree(shared_mcts_tree &st) {
+        unsigned first_call = nb_calls;
+        nb_iterations = 0;
+        peak_tree_bytes = 0;
+        do {
+            search_shared_tree(st,0);
+            ++nb_iterations;
+        } while(!is_search_over(first_call));
+    }
+
+    /**
+     * @brief Get search thread
+     *
+     * @return Return the policy running the k-th search thread, the first one being this
+     * policy and the other ones its workers.
+     */
+    mcts_policy * get_search_thread(unsigned k) {
+        return (k == 0) ? this : workers[k-1].get();
+    }
+
+    /**
+     * @brief Apply the policy with a shared tree
+     *
+     * Every search thread spends the budget in the same tree, which is rebuilt at each
+     * application; it is allocated with enough room for all the iterations once and for all,
+     * hence it is not pruned and the tree memory limit does not apply to it.
+     */
+    action apply_tree_parallel(const state &s) {
+        if(!shared_tree) {
+            const map_graph &g = *envt_ptr->graph;
+            unsigned nb_iterations = nb_search_threads * budget;
+            shared_tree.reset(new shared_mcts_tree(
+                nb_iterations + 1,
+                nb_iterations,
+                (nb_iterations + 1) * std::max(g.get_max_nb_edges(),1u)
+            ));
+            shared_tree->time_quantum = time_quantum;
+        }
+        shared_tree->clear();
+        shared_tree->add_root(s);
+        for(unsigned k=0; k<nb_search_threads; ++k) {
+            get_search_thread(k)->reference_time = s.t;
+        }
+        parallel_run(nb_search_threads,[this](unsigned k) {
+            get_search_thread(k)->build_shared_tree(*shared_tree);
+        });
+        peak_tree_bytes = shared_tree->get_nb_bytes(); // allocated once for the whole search
+        for(auto &w : workers) {
+            nb_calls += w->nb_calls;
+            w->nb_calls = 0;
+        }
+        return recommended_action(*shared_tree,0);
+    }
+
+    /**
+     * @brief Apply the policy with a tree per thread
+     *
+     * Each iteration creates at most one decision and one chance node.
+     * If the tree is reused and was re-rooted at the input state, the budget is spent on
+     * top of the kept subtree.
+     * With several search threads, each one builds its own tree and the statistics of the
+     * root's children are merged before recommending an action.
+     */
+    action apply_root_parallel(const state &s) {
+        for(unsigned k=0; k<nb_search_threads; ++k) {
+            get_search_thread(k)->set_root(s);
+        }
+        parallel_run(nb_search_threads,[this](unsigned k) {
+            get_search_thread(k)->build_tree();
+        });
+        for(auto &w : workers) {
+            merge_root_statistics(w->tree);
+            nb_calls += w->nb_calls;
+            w->nb_calls = 0;
+        }
+        //print_first_layer(0); //TODO remove
+        return recommended_action(tree,0);
+    }
+
     /**
      * @brief Apply the policy
+     *
+     * Every search thread has its own random stream and stops at the first of its budget,
+     * the per-decision deadline or its limit on generative model calls; it always returns
+     * the best action found so far.
      */
     action apply(const state &s) override {
         //tt(s); //TODO remove
-        reference_time = s.t;
-        dnode root(s);
-        build_tree(root);
-        //print_first_layer(root); //TODO remove
-        return recommended_action(root);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        unsigned first_call = nb_calls;
+        uint64_t seed = rand();
+        for(unsigned k=0; k<nb_search_threads; ++k) {
+            get_search_thread(k)->deadline = start + std::chrono::microseconds(time_limit);
+            get_search_thread(k)->rng = xoshiro_rng(seed,k);
+        }
+        action a = tree_parallel ? apply_tree_parallel(s) : apply_root_parallel(s);
+        last_decision.duration = std::chrono::duration<double,std::micro>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+        last_decision.nb_iterations = 0;
+        last_decision.peak_tree_bytes = 0;
+        for(unsigned k=0; k<nb_search_threads; ++k) {
+            last_decision.nb_iterations += get_search_thread(k)->nb_iterations;
+            last_decision.peak_tree_bytes += get_search_thread(k)->peak_tree_bytes;
+        }
+        last_decision.nb_calls = nb_calls - first_call;
+        return a;
+    }
+
+    decision_statistics get_decision_statistics() const override {
+        return last_decision;
     }
 
     void process_reward(
@@ -380,6 +720,40 @@ public:
         (void) s_p;
         // Nothing to process for MCTS policy
     }
+
+    /**
+     * @brief Is tree reused
+     *
+     * The tree is only reused with a dynamic model since the transitions of a static model
+     * depend on the time of the root.
+     */
+    bool is_tree_reused() const {
+        return reuse_tree && is_model_dynamic;
+    }
+
+    /**
+     * @brief Step
+     *
+     * If the tree is reused, re-root it at the decision node matching the observed successor
+     * state, the rest of the tree being freed; else or if there is no such node, clear it.
+     * @param {const action &} a; applied action
+     * @param {const state &} s_p; observed successor state
+     */
+    void step(const action &a, const state &s_p) override {
+        for(auto &w : workers) {
+            w->step(a,s_p);
+        }
+        if(!is_tree_reused() || tree.get_nb_dnodes() == 0) {
+            return;
+        }
+        unsigned c = tree.find_action(0,a);
+        unsigned d = (c == NO_NODE) ? NO_NODE : tree.find_successor(0,c,s_p);
+        if(d == NO_NODE) {
+            tree.clear();
+        } else {
+            tree.reroot(d);
+        }
+    }
 };
 
 #endif // MCTS_POLICY_HPP_
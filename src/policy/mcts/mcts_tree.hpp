@@ -0,0 +1,808 @@
+#ifndef MCTS_TREE_HPP_
+#define MCTS_TREE_HPP_
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include <node_index.hpp>
+#include <rng.hpp>
+#include <running_statistics.hpp>
+
+/** @brief Indice of no node, e.g. the sibling of a last child */
+constexpr unsigned NO_NODE = UINT_MAX;
+
+/** @brief Number of decision node children from which the children of a chance node are indexed */
+constexpr unsigned SUCCESSORS_INDEX_THRESHOLD = 8;
+
+/** @brief Fraction of its reserved nodes down to which a tree is pruned */
+constexpr double TREE_PRUNING_TARGET = .75;
+
+/**
+ * @brief Get time bucket
+ *
+ * Get the bucket of a time: states whose times fall in the same bucket are merged.
+ * @param {double} t; time
+ * @param {double} time_quantum; width of the buckets, 0 for one bucket per time
+ * @return Return the bucket as a 64-bit integer.
+ */
+inline uint64_t get_time_bucket(double t, double time_quantum) {
+    if(time_quantum > 0.) {
+        return (uint64_t) (int64_t) std::floor(t / time_quantum);
+    }
+    uint64_t bucket = 0;
+    std::memcpy(&bucket,&t,sizeof(bucket));
+    return bucket;
+}
+
+/**
+ * @brief Path step
+ *
+ * Step of a descent in a search tree: visited chance node and reward of the transition
+ * sampled from it.
+ */
+struct path_step {
+    unsigned c; ///< Visited chance node
+    double r; ///< Sampled reward
+};
+
+/**
+ * @brief MCTS tree class
+ *
+ * Search tree stored as a structure of arrays: decision and chance nodes are 32-bit
+ * indices into parallel arrays, the root being the decision node 0.
+ * A decision node is labelled by a state, stored as a time and a map node id; a chance
+ * node is labelled by an action, its state being the one of its parent.
+ * The children of a node are linked through the first child and sibling arrays, in order
+ * of creation.
+ * A sampled successor state falling in the time bucket of an existing decision node child
+ * of the chance node, see get_time_bucket, is merged into it. The children of the chance
+ * nodes with many of them are indexed by a hash table keyed on the chance node and the map
+ * node id and time bucket of their state, the other ones are scanned.
+ * If transpositions are shared, the decision nodes are also indexed by the map node id and
+ * time bucket of their state alone, and a successor state reached through another path is
+ * merged into the existing node, which turns the tree into a directed acyclic graph, see
+ * find_successor. Each decision node is still the child of a single chance node, the one it
+ * was created from, hence the tree walks visit it once.
+ * The actions of a decision node are a block of the actions pool, the expanded ones first.
+ * The arrays keep their capacity when the tree is cleared, hence successive searches reuse
+ * the same memory.
+ * The memory of the tree can be bounded: the arrays are then reserved once for as many nodes
+ * as fit in the limit, see reserve_memory, and the least visited subtrees are pruned before
+ * they are outgrown, see has_room and prune. The slots of the removed nodes are recycled by
+ * the next created nodes, hence the indices of the live nodes are not contiguous any more,
+ * and the actions pool is compacted.
+ */
+class mcts_tree {
+public:
+    const map_graph * graph_ptr; ///< Graph of the labelling states
+    double time_quantum; ///< Width of the time buckets of the successor states, 0 for exact times
+    bool share_transpositions; ///< Merge the decision nodes with the same map node and time bucket
+
+    // Decision nodes
+    std::vector<double> d_time; ///< Time of the labelling state
+    std::vector<unsigned> d_node_id; ///< Map node id of the labelling state
+    std::vector<unsigned> d_actions; ///< Indice of the first action in the actions pool
+    std::vector<unsigned> d_nb_actions; ///< Number of actions
+    std::vector<unsigned> d_nb_children; ///< Number of children ie of expanded actions
+    std::vector<unsigned> d_nb_visits; ///< Number of times the node was reached from its parent
+    std::vector<unsigned> d_first_child; ///< First chance node child
+    std::vector<unsigned> d_sibling; ///< Next decision node child of the same chance node
+
+    // Chance nodes
+    std::vector<unsigned> c_action; ///< Indice of the labelling action
+    std::vector<running_statistics> c_returns; ///< Statistics of the sampled returns
+    std::vector<unsigned> c_nb_successors; ///< Number of decision node children
+    std::vector<unsigned> c_first_child; ///< First decision node child
+    std::vector<unsigned> c_sibling; ///< Next chance node child of the same decision node
+
+    std::vector<unsigned> actions_pool; ///< Actions of each decision node
+    node_index children_index; ///< Decision node children of the chance nodes with many of them
+    node_index transpositions_index; ///< Decision nodes by map node and time bucket, if transpositions are shared
+
+    // Recycled slots
+    std::vector<unsigned> free_dnodes; ///< Slots of the pruned decision nodes
+    std::vector<unsigned> free_cnodes; ///< Slots of the pruned chance nodes
+
+    // Bounded memory
+    unsigned max_nb_nodes; ///< Number of nodes of each kind the arrays are reserved for, 0 if the memory is not bounded
+    unsigned max_nb_actions; ///< Maximum number of actions of a decision node
+    std::vector<std::pair<unsigned,unsigned>> prune_candidates; ///< Buffer of the chance nodes to prune, with their parent
+    std::vector<unsigned> prune_queue; ///< Buffer of the nodes walked when pruning
+
+    mcts_tree() :
+        graph_ptr(nullptr),
+        time_quantum(0.),
+        share_transpositions(false),
+        max_nb_nodes(0),
+        max_nb_actions(0)
+    {}
+
+    unsigned get_nb_dnodes() const {
+        return d_time.size() - free_dnodes.size();
+    }
+
+    unsigned get_nb_cnodes() const {
+        return c_action.size() - free_cnodes.size();
+    }
+
+    /**
+     * @brief Get number of bytes
+     *
+     * @return Return the number of bytes allocated by the tree, ie the capacities of its
+     * arrays, free lists, buffers and index slots, whether they hold live nodes or not.
+     */
+    size_t get_nb_bytes() const {
+        return get_capacity_bytes(d_time) + get_capacity_bytes(d_node_id) + get_capacity_bytes(d_actions)
+            + get_capacity_bytes(d_nb_actions) + get_capacity_bytes(d_nb_children)
+            + get_capacity_bytes(d_nb_visits) + get_capacity_bytes(d_first_child) + get_capacity_bytes(d_sibling)
+            + get_capacity_bytes(c_action) + get_capacity_bytes(c_returns) + get_capacity_bytes(c_nb_successors)
+            + get_capacity_bytes(c_first_child) + get_capacity_bytes(c_sibling)
+            + get_capacity_bytes(actions_pool)
+            + get_capacity_bytes(children_index.slots) + get_capacity_bytes(transpositions_index.slots)
+            + get_capacity_bytes(free_dnodes) + get_capacity_bytes(free_cnodes)
+            + get_capacity_bytes(prune_candidates) + get_capacity_bytes(prune_queue);
+    }
+
+    /**
+     * @brief Clear
+     *
+     * Remove every node, the memory being kept for the next tree.
+     */
+    void clear() {
+        d_time.clear();
+        d_node_id.clear();
+        d_actions.clear();
+        d_nb_actions.clear();
+        d_nb_children.clear();
+        d_nb_visits.clear();
+        d_first_child.clear();
+        d_sibling.clear();
+        c_action.clear();
+        c_returns.clear();
+        c_nb_successors.clear();
+        c_first_child.clear();
+        c_sibling.clear();
+        actions_pool.clear();
+        children_index.clear();
+        transpositions_index.clear();
+        free_dnodes.clear();
+        free_cnodes.clear();
+    }
+
+    /**
+     * @brief Reserve
+     *
+     * Reserve the arrays for the given number of nodes of each kind, the decision nodes
+     * having at most the given number of actions, so that they are not reallocated as long
+     * as the tree has room, see has_room.
+     * The chance nodes get max_nb_actions more slots for the children merged into the root
+     * after a root-parallel search.
+     */
+    void reserve(unsigned nb_nodes, unsigned nb_actions) {
+        max_nb_nodes = nb_nodes;
+        max_nb_actions = nb_actions;
+        unsigned nb_cnodes = nb_nodes + nb_actions;
+        d_time.reserve(nb_nodes);
+        d_node_id.reserve(nb_nodes);
+        d_actions.reserve(nb_nodes);
+        d_nb_actions.reserve(nb_nodes);
+        d_nb_children.reserve(nb_nodes);
+        d_nb_visits.reserve(nb_nodes);
+        d_first_child.reserve(nb_nodes);
+        d_sibling.reserve(nb_nodes);
+        c_action.reserve(nb_cnodes);
+        c_returns.reserve(nb_cnodes);
+        c_nb_successors.reserve(nb_cnodes);
+        c_first_child.reserve(nb_cnodes);
+        c_sibling.reserve(nb_cnodes);
+        actions_pool.reserve((size_t) nb_nodes * nb_actions);
+        children_index.reserve(nb_nodes);
+        if(share_transpositions) {
+            transpositions_index.reserve(nb_nodes);
+        }
+        free_dnodes.reserve(nb_nodes);
+        free_cnodes.reserve(nb_cnodes);
+        prune_candidates.reserve(nb_cnodes);
+        prune_queue.reserve(nb_cnodes);
+    }
+
+    /**
+     * @brief Reserve memory
+     *
+     * Reserve the arrays for as many nodes as fit in the given number of bytes, at least one,
+     * see reserve.
+     * Each node of the limit is counted as a decision node with the given maximum number of
+     * actions, a chance node, their slots in the free lists, buffers and indices, and the
+     * given number of bytes the caller keeps per chance node.
+     * @param {size_t} nb_bytes; memory limit
+     * @param {unsigned} nb_actions; maximum number of actions of a decision node
+     * @param {size_t} cnode_extra_bytes; number of bytes of the caller per chance node
+     */
+    void reserve_memory(size_t nb_bytes, unsigned nb_actions, size_t cnode_extra_bytes = 0) {
+        size_t nb_indices = share_transpositions ? 2 : 1;
+        size_t dnode_bytes = sizeof(double) + 8 * sizeof(unsigned) + nb_actions * sizeof(unsigned);
+        size_t cnode_bytes = 4 * sizeof(unsigned) + sizeof(running_statistics) + cnode_extra_bytes
+            + 2 * sizeof(unsigned) + sizeof(std::pair<unsigned,unsigned>);
+        size_t fixed_bytes = nb_actions * cnode_bytes + nb_indices * 2 * sizeof(node_index::entry);
+        size_t node_bytes = dnode_bytes + cnode_bytes + nb_indices * 2 * sizeof(node_index::entry);
+        size_t nb_nodes = (nb_bytes > fixed_bytes) ? (nb_bytes - fixed_bytes) / node_bytes : 0;
+        reserve((unsigned) std::max(std::min(nb_nodes,(size_t) UINT_MAX / 2),(size_t) 1),nb_actions);
+    }
+
+    /**
+     * @brief Has room
+     *
+     * Test whether an iteration of search, which creates at most one node of each kind, can
+     * run without outgrowing the reserved arrays; always true if the memory is not bounded.
+     */
+    bool has_room() const {
+        return max_nb_nodes == 0 || (get_nb_dnodes() < max_nb_nodes && get_nb_cnodes() < max_nb_nodes);
+    }
+
+    /**
+     * @brief Get state
+     *
+     * @return Return the labelling state of a decision node.
+     */
+    state get_state(unsigned d) const {
+        return state(d_time[d],&graph_ptr->nodes_vector[d_node_id[d]]);
+    }
+
+    action get_action(unsigned c) const {
+        return action(c_action[c]);
+    }
+
+    /**
+     * @brief Get value
+     *
+     * @return Return the mean of the sampled returns of a chance node.
+     */
+    double get_value(unsigned c) const {
+        return c_returns[c].get_mean();
+    }
+
+    unsigned get_nb_visits(unsigned c) const {
+        return c_returns[c].get_count();
+    }
+
+    unsigned get_first_child(unsigned d) const {
+        return d_first_child[d];
+    }
+
+    unsigned get_next_sibling(unsigned c) const {
+        return c_sibling[c];
+    }
+
+    /**
+     * @brief Get child
+     *
+     * @return Return the k-th chance node child of a decision node.
+     */
+    unsigned get_child(unsigned d, unsigned k) const {
+        unsigned c = d_first_child[d];
+        for(; k>0; --k) {
+            c = c_sibling[c];
+        }
+        return c;
+    }
+
+    /**
+     * @brief Is fully expanded
+     *
+     * Test whether every action of a decision node has been expanded.
+     */
+    bool is_fully_expanded(unsigned d) const {
+        return d_nb_children[d] == d_nb_actions[d];
+    }
+
+    /**
+     * @brief Add decision node
+     *
+     * @param {const state &} s; labelling state
+     * @param {unsigned} parent; parent chance node, NO_NODE for the root
+     * @return Return the indice of the created decision node.
+     */
+    unsigned add_dnode(const state &s, unsigned parent = NO_NODE) {
+        unsigned d = allocate_dnode();
+        unsigned nb_actions = s.get_nb_actions();
+        graph_ptr = s.nd_ptr->graph_ptr;
+        d_time[d] = s.t;
+        d_node_id[d] = s.nd_ptr->id;
+        d_actions[d] = allocate_actions(nb_actions);
+        d_nb_actions[d] = nb_actions;
+        d_nb_children[d] = 0;
+        d_nb_visits[d] = 1;
+        d_first_child[d] = NO_NODE;
+        d_sibling[d] = NO_NODE;
+        for(unsigned k=0; k<nb_actions; ++k) {
+            actions_pool[d_actions[d] + k] = k;
+        }
+        if(parent != NO_NODE) {
+            link_dnode(d,parent);
+        }
+        index_transposition(d);
+        return d;
+    }
+
+    /**
+     * @brief Expand
+     *
+     * Create a chance node child of a decision node, labelled by an action picked at
+     * random with the given generator amongst the ones not expanded yet.
+     * Template method.
+     * @return Return the indice of the created chance node.
+     * @warning The decision node must not be fully expanded.
+     */
+    template <class G>
+    unsigned expand(unsigned d, G &generator) {
+        assert(!is_fully_expanded(d));
+        unsigned k = d_nb_children[d];
+        return expand_at(d,uniform_integer(generator,k,d_nb_actions[d]-1));
+    }
+
+    /**
+     * @brief Expand action
+     *
+     * Create a chance node child of a decision node, labelled by the given action.
+     * @return Return the indice of the created chance node.
+     * @warning The action must not be expanded yet.
+     */
+    unsigned expand_action(unsigned d, const action &a) {
+        unsigned i = d_nb_children[d];
+        while(actions_pool[d_actions[d] + i] != a.indice) {
+            ++i;
+            assert(i < d_nb_actions[d]);
+        }
+        return expand_at(d,i);
+    }
+
+    /**
+     * @brief Expand at
+     *
+     * Create a chance node child of a decision node, labelled by its i-th action which is
+     * not expanded yet.
+     * The remaining actions keep their relative order.
+     * @return Return the indice of the created chance node.
+     */
+    unsigned expand_at(unsigned d, unsigned i) {
+        unsigned c = allocate_cnode();
+        unsigned k = d_nb_children[d];
+        unsigned * actions = &actions_pool[d_actions[d]];
+        std::rotate(actions + k,actions + i,actions + i + 1);
+        c_action[c] = actions[k];
+        c_returns[c] = running_statistics();
+        c_nb_successors[c] = 0;
+        c_first_child[c] = NO_NODE;
+        c_sibling[c] = NO_NODE;
+        unsigned * link = &d_first_child[d];
+        while(*link != NO_NODE) {
+            link = &c_sibling[*link];
+        }
+        *link = c;
+        ++d_nb_children[d];
+        return c;
+    }
+
+    /**
+     * @brief Copy decision node
+     *
+     * Append a copy of a decision node of another tree, without its children.
+     * The tree must have no recycled slot.
+     * @param {const mcts_tree &} t; tree of the copied node
+     * @param {unsigned} d; copied decision node
+     * @param {unsigned} parent; parent chance node of the copy, NO_NODE for the root
+     * @return Return the indice of the copy.
+     */
+    unsigned copy_dnode(const mcts_tree &t, unsigned d, unsigned parent) {
+        unsigned nd = get_nb_dnodes();
+        d_time.push_back(t.d_time[d]);
+        d_node_id.push_back(t.d_node_id[d]);
+        d_actions.push_back(actions_pool.size());
+        d_nb_actions.push_back(t.d_nb_actions[d]);
+        d_nb_children.push_back(t.d_nb_children[d]);
+        d_nb_visits.push_back(t.d_nb_visits[d]);
+        d_first_child.push_back(NO_NODE);
+        d_sibling.push_back(NO_NODE);
+        actions_pool.insert(
+            actions_pool.end(),
+            t.actions_pool.begin() + t.d_actions[d],
+            t.actions_pool.begin() + t.d_actions[d] + t.d_nb_actions[d]
+        );
+        if(parent != NO_NODE) {
+            link_dnode(nd,parent);
+        }
+        index_transposition(nd);
+        return nd;
+    }
+
+    /**
+     * @brief Copy chance node
+     *
+     * Append a copy of a chance node of another tree, without its children, as the last
+     * child of a decision node.
+     * The tree must have no recycled slot.
+     * @param {const mcts_tree &} t; tree of the copied node
+     * @param {unsigned} c; copied chance node
+     * @param {unsigned} parent; parent decision node of the copy
+     * @param {unsigned} previous; previous child of the parent, NO_NODE if there is none
+     * @return Return the indice of the copy.
+     */
+    unsigned copy_cnode(const mcts_tree &t, unsigned c, unsigned parent, unsigned previous) {
+        unsigned nc = get_nb_cnodes();
+        c_action.push_back(t.c_action[c]);
+        c_returns.push_back(t.c_returns[c]);
+        c_nb_successors.push_back(0); // incremented as the children are copied
+        c_first_child.push_back(NO_NODE);
+        c_sibling.push_back(NO_NODE);
+        if(previous == NO_NODE) {
+            d_first_child[parent] = nc;
+        } else {
+            c_sibling[previous] = nc;
+        }
+        return nc;
+    }
+
+    /**
+     * @brief Reroot
+     *
+     * Keep only the subtree of the given decision node, which becomes the root; the rest
+     * of the tree is freed.
+     * The subtree is copied breadth-first into compact arrays and the children keep their
+     * order; if the memory is bounded, the arrays of the copy are reserved as the ones of
+     * the tree, hence both are allocated during the copy.
+     * @return Return the former indice of each chance node of the new tree.
+     */
+    std::vector<unsigned> reroot(unsigned root) {
+        mcts_tree t;
+        t.graph_ptr = graph_ptr;
+        t.time_quantum = time_quantum;
+        t.share_transpositions = share_transpositions;
+        if(max_nb_nodes > 0) {
+            t.reserve(max_nb_nodes,max_nb_actions);
+        }
+        std::vector<unsigned> cnodes_origins;
+        std::vector<std::pair<unsigned,unsigned>> queue = {{root,NO_NODE}}; // (decision node, parent of its copy)
+        for(size_t i=0; i<queue.size(); ++i) {
+            unsigned d = queue[i].first;
+            unsigned nd = t.copy_dnode(*this,d,queue[i].second);
+            unsigned previous = NO_NODE;
+            for(unsigned c = d_first_child[d]; c != NO_NODE; c = c_sibling[c]) {
+                previous = t.copy_cnode(*this,c,nd,previous);
+                cnodes_origins.push_back(c);
+                for(unsigned e = c_first_child[c]; e != NO_NODE; e = d_sibling[e]) {
+                    queue.emplace_back(e,previous);
+                }
+            }
+        }
+        *this = std::move(t);
+        return cnodes_origins;
+    }
+
+    /**
+     * @brief Find action
+     *
+     * @return Return the chance node child of a decision node labelled by the given action,
+     * NO_NODE if there is none.
+     */
+    unsigned find_action(unsigned d, const action &a) const {
+        for(unsigned c = d_first_child[d]; c != NO_NODE; c = c_sibling[c]) {
+            if(c_action[c] == a.indice) {
+                return c;
+            }
+        }
+        return NO_NODE;
+    }
+
+    /**
+     * @brief Is merged into
+     *
+     * Test whether a state has the map node and falls in the time bucket of a decision node,
+     * ie whether it is merged into it.
+     */
+    bool is_merged_into(unsigned d, const state &s) const {
+        return d_node_id[d] == s.nd_ptr->id
+            && get_time_bucket(d_time[d],time_quantum) == get_time_bucket(s.t,time_quantum);
+    }
+
+    /**
+     * @brief Find child
+     *
+     * @return Return the decision node child of a chance node whose state has the map node
+     * and the time bucket of the given state, NO_NODE if there is none.
+     */
+    unsigned find_child(unsigned c, const state &s) const {
+        uint64_t bucket = get_time_bucket(s.t,time_quantum);
+        if(c_nb_successors[c] >= SUCCESSORS_INDEX_THRESHOLD) {
+            return children_index.find(c,s.nd_ptr->id,bucket);
+        }
+        for(unsigned d = c_first_child[c]; d != NO_NODE; d = d_sibling[d]) {
+            if(d_node_id[d] == s.nd_ptr->id && get_time_bucket(d_time[d],time_quantum) == bucket) {
+                return d;
+            }
+        }
+        return NO_NODE;
+    }
+
+    /**
+     * @brief Find successor
+     *
+     * Find the decision node reached from a chance node when a state is sampled: its child
+     * with the map node and time bucket of the state or else, if transpositions are shared,
+     * the decision node with this map node and time bucket wherever it is in the tree.
+     * A transposition is only followed if its time is greater than the one of the parent of
+     * the chance node, the times never decreasing along the paths, so that the graph has no
+     * cycle.
+     * @param {unsigned} d; parent decision node of the chance node
+     * @param {unsigned} c; chance node
+     * @param {const state &} s; sampled state
+     * @return Return the reached decision node, NO_NODE if there is none.
+     */
+    unsigned find_successor(unsigned d, unsigned c, const state &s) const {
+        unsigned e = find_child(c,s);
+        if(e == NO_NODE && share_transpositions) {
+            e = transpositions_index.find(s.nd_ptr->id,0,get_time_bucket(s.t,time_quantum));
+            if(e != NO_NODE && !(d_time[e] > d_time[d])) {
+                e = NO_NODE;
+            }
+        }
+        return e;
+    }
+
+    unsigned get_nb_successors(unsigned c) const {
+        return c_nb_successors[c];
+    }
+
+    /**
+     * @brief Sample successor
+     *
+     * Pick a decision node child of a chance node with a probability proportional to the
+     * number of times it was reached.
+     * Template method.
+     * @warning The chance node must have at least one child.
+     */
+    template <class G>
+    unsigned sample_successor(unsigned c, G &generator) const {
+        unsigned nb_visits = 0;
+        for(unsigned d = c_first_child[c]; d != NO_NODE; d = d_sibling[d]) {
+            nb_visits += d_nb_visits[d];
+        }
+        int i = uniform_integer(generator,0,nb_visits-1);
+        unsigned d = c_first_child[c];
+        for(i -= d_nb_visits[d]; i >= 0; i -= d_nb_visits[d]) {
+            d = d_sibling[d];
+        }
+        return d;
+    }
+
+    /**
+     * @brief Prune
+     *
+     * Remove the least visited subtrees until the tree holds at most the given fraction of
+     * its reserved nodes of each kind, see reserve, then compact the actions pool.
+     * The pruned subtrees are the ones of the chance nodes below the children of the root,
+     * by increasing number of visits; the action of a pruned chance node is unexpanded.
+     * Pruning down to a fraction lower than 1 leaves room for many iterations before the
+     * next pruning, whose cost is spread over them.
+     * @param {double} fraction; targeted fraction of the reserved nodes
+     * @return Return false if the root, its children and grandchildren exceed the target.
+     */
+    bool prune(double fraction) {
+        unsigned nb_nodes = (unsigned) (fraction * max_nb_nodes);
+        prune_candidates.clear();
+        prune_queue.clear();
+        for(unsigned c = d_first_child[0]; c != NO_NODE; c = c_sibling[c]) {
+            for(unsigned e = c_first_child[c]; e != NO_NODE; e = d_sibling[e]) {
+                prune_queue.push_back(e);
+            }
+        }
+        for(size_t i=0; i<prune_queue.size(); ++i) {
+            unsigned d = prune_queue[i];
+            for(unsigned c = d_first_child[d]; c != NO_NODE; c = c_sibling[c]) {
+                prune_candidates.emplace_back(c,d);
+                for(unsigned e = c_first_child[c]; e != NO_NODE; e = d_sibling[e]) {
+                    prune_queue.push_back(e);
+                }
+            }
+        }
+        std::sort(prune_candidates.begin(),prune_candidates.end(), // in place, ties by slot
+            [this](const std::pair<unsigned,unsigned> &x, const std::pair<unsigned,unsigned> &y) {
+                return get_nb_visits(x.first) < get_nb_visits(y.first)
+                    || (get_nb_visits(x.first) == get_nb_visits(y.first) && x.first < y.first);
+            }
+        );
+        for(const auto &cd : prune_candidates) {
+            if(get_nb_dnodes() <= nb_nodes && get_nb_cnodes() <= nb_nodes) {
+                break;
+            }
+            if(c_action[cd.first] != NO_NODE) { // not pruned with an ancestor yet
+                unexpand(cd.second,cd.first);
+            }
+        }
+        compact_actions();
+        return get_nb_dnodes() <= nb_nodes && get_nb_cnodes() <= nb_nodes;
+    }
+
+private:
+    /**
+     * @brief Allocate decision node
+     *
+     * @return Return a recycled slot of decision node, or else a new one.
+     */
+    unsigned allocate_dnode() {
+        if(!free_dnodes.empty()) {
+            unsigned d = free_dnodes.back();
+            free_dnodes.pop_back();
+            return d;
+        }
+        d_time.emplace_back();
+        d_node_id.emplace_back();
+        d_actions.emplace_back();
+        d_nb_actions.emplace_back();
+        d_nb_children.emplace_back();
+        d_nb_visits.emplace_back();
+        d_first_child.emplace_back();
+        d_sibling.emplace_back();
+        return d_time.size() - 1;
+    }
+
+    /**
+     * @brief Allocate chance node
+     *
+     * @return Return a recycled slot of chance node, or else a new one.
+     */
+    unsigned allocate_cnode() {
+        if(!free_cnodes.empty()) {
+            unsigned c = free_cnodes.back();
+            free_cnodes.pop_back();
+            return c;
+        }
+        c_action.emplace_back();
+        c_returns.emplace_back();
+        c_nb_successors.emplace_back();
+        c_first_child.emplace_back();
+        c_sibling.emplace_back();
+        return c_action.size() - 1;
+    }
+
+    /**
+     * @brief Allocate actions
+     *
+     * @return Return the indice of a new block of the given number of actions at the end of
+     * the actions pool.
+     */
+    unsigned allocate_actions(unsigned nb_actions) {
+        unsigned i = actions_pool.size();
+        actions_pool.resize(i + nb_actions);
+        return i;
+    }
+
+    /**
+     * @brief Compact actions
+     *
+     * Move the blocks of actions of the live decision nodes to the front of the actions
+     * pool, in order, so that the blocks of the pruned ones are reclaimed.
+     */
+    void compact_actions() {
+        prune_queue.clear();
+        for(unsigned d=0; d<d_time.size(); ++d) {
+            if(d_actions[d] != NO_NODE) {
+                prune_queue.push_back(d);
+            }
+        }
+        std::sort(prune_queue.begin(),prune_queue.end(),
+            [this](unsigned x, unsigned y) {
+                return d_actions[x] < d_actions[y];
+            }
+        );
+        unsigned i = 0;
+        for(unsigned d : prune_queue) {
+            if(d_actions[d] != i) { // moved towards the front
+                std::copy(
+                    actions_pool.begin() + d_actions[d],
+                    actions_pool.begin() + d_actions[d] + d_nb_actions[d],
+                    actions_pool.begin() + i
+                );
+                d_actions[d] = i;
+            }
+            i += d_nb_actions[d];
+        }
+        actions_pool.resize(i);
+    }
+
+    /**
+     * @brief Unexpand
+     *
+     * Remove a chance node child of a decision node with its whole subtree, its action
+     * moving back to the unexpanded ones.
+     */
+    void unexpand(unsigned d, unsigned c) {
+        unsigned * link = &d_first_child[d];
+        while(*link != c) {
+            link = &c_sibling[*link];
+        }
+        *link = c_sibling[c];
+        unsigned * actions = &actions_pool[d_actions[d]];
+        unsigned k = d_nb_children[d];
+        unsigned i = std::find(actions,actions + k,c_action[c]) - actions;
+        std::rotate(actions + i,actions + i + 1,actions + k);
+        --d_nb_children[d];
+        std::vector<unsigned> &stack = prune_queue; // chance nodes to free
+        stack.assign(1,c);
+        while(!stack.empty()) {
+            unsigned x = stack.back();
+            stack.pop_back();
+            for(unsigned e = c_first_child[x]; e != NO_NODE;) {
+                unsigned next = d_sibling[e];
+                if(c_nb_successors[x] >= SUCCESSORS_INDEX_THRESHOLD) {
+                    children_index.erase(x,d_node_id[e],get_time_bucket(d_time[e],time_quantum));
+                }
+                for(unsigned y = d_first_child[e]; y != NO_NODE; y = c_sibling[y]) {
+                    stack.push_back(y);
+                }
+                free_dnode(e);
+                e = next;
+            }
+            c_action[x] = NO_NODE;
+            free_cnodes.push_back(x);
+        }
+    }
+
+    void free_dnode(unsigned d) {
+        uint64_t bucket = get_time_bucket(d_time[d],time_quantum);
+        if(share_transpositions && transpositions_index.find(d_node_id[d],0,bucket) == d) {
+            transpositions_index.erase(d_node_id[d],0,bucket);
+        }
+        d_actions[d] = NO_NODE;
+        free_dnodes.push_back(d);
+    }
+
+    /**
+     * @brief Link decision node
+     *
+     * Append a decision node to the children of a chance node, the children being indexed
+     * once there are SUCCESSORS_INDEX_THRESHOLD of them.
+     */
+    void link_dnode(unsigned d, unsigned parent) {
+        unsigned * link = &c_first_child[parent];
+        while(*link != NO_NODE) {
+            link = &d_sibling[*link];
+        }
+        *link = d;
+        unsigned nb_successors = ++c_nb_successors[parent];
+        if(nb_successors == SUCCESSORS_INDEX_THRESHOLD) {
+            for(unsigned e = c_first_child[parent]; e != NO_NODE; e = d_sibling[e]) {
+                index_dnode(e,parent);
+            }
+        } else if(nb_successors > SUCCESSORS_INDEX_THRESHOLD) {
+            index_dnode(d,parent);
+        }
+    }
+
+    template <class T>
+    static size_t get_capacity_bytes(const std::vector<T> &v) {
+        return v.capacity() * sizeof(T);
+    }
+
+    void index_dnode(unsigned d, unsigned parent) {
+        children_index.insert(parent,d_node_id[d],get_time_bucket(d_time[d],time_quantum),d);
+    }
+
+    /**
+     * @brief Index transposition
+     *
+     * Index a decision node by its map node and time bucket if transpositions are shared
+     * and no node is indexed with them yet.
+     */
+    void index_transposition(unsigned d) {
+        if(!share_transpositions) {
+            return;
+        }
+        uint64_t bucket = get_time_bucket(d_time[d],time_quantum);
+        if(transpositions_index.find(d_node_id[d],0,bucket) == NO_NODE) {
+            transpositions_index.insert(d_node_id[d],0,bucket,d);
+        }
+    }
+};
+
+#endif // MCTS_TREE_HPP_
@@ -0,0 +1,166 @@
+#ifndef NODE_INDEX_HPP_
+#define NODE_INDEX_HPP_
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+#include <rng.hpp>
+
+/**
+ * @brief Node index
+ *
+ * Hash table mapping keys made of two 32-bit integers and a 64-bit time bucket to the
+ * indices of the nodes of a tree, with open addressing and linear probing.
+ * The number of slots is doubled when the table gets half full, unless it was reserved for
+ * enough entries, and the slots keep their memory when the table is cleared.
+ */
+class node_index {
+public:
+    /**
+     * @brief Entry
+     */
+    struct entry {
+        uint64_t bucket; ///< Time bucket of the key
+        unsigned a; ///< First integer of the key
+        unsigned b; ///< Second integer of the key
+        unsigned node; ///< Indexed node, UINT_MAX for an empty slot
+    };
+
+    std::vector<entry> slots; ///< Slots of the table
+    unsigned nb_entries; ///< Number of indexed nodes
+
+    node_index() : nb_entries(0) {}
+
+    /**
+     * @brief Clear
+     *
+     * Remove every entry, the memory being kept.
+     */
+    void clear() {
+        for(auto &sl : slots) {
+            sl.node = UINT_MAX;
+        }
+        nb_entries = 0;
+    }
+
+    /**
+     * @brief Reserve
+     *
+     * Make room for the given number of entries, so that the slots are not reallocated as
+     * long as the table holds at most as many entries.
+     */
+    void reserve(unsigned nb_max_entries) {
+        if(slots.size() < 2 * (size_t) nb_max_entries + 2) {
+            rehash(2 * (size_t) nb_max_entries + 2);
+        }
+    }
+
+    /**
+     * @brief Find
+     *
+     * @return Return the node indexed by the key, UINT_MAX if there is none.
+     */
+    unsigned find(unsigned a, unsigned b, uint64_t bucket) const {
+        if(slots.empty()) {
+            return UINT_MAX;
+        }
+        for(size_t i = home(a,b,bucket); slots[i].node != UINT_MAX; i = next(i)) {
+            const entry &sl = slots[i];
+            if(sl.bucket == bucket && sl.a == a && sl.b == b) {
+                return sl.node;
+            }
+        }
+        return UINT_MAX;
+    }
+
+    /**
+     * @brief Insert
+     *
+     * Index a node by a key, which must not be indexed yet.
+     */
+    void insert(unsigned a, unsigned b, uint64_t bucket, unsigned node) {
+        if(2 * (nb_entries + 1) > slots.size()) {
+            rehash(std::max(slots.size() * 2,(size_t) 16));
+        }
+        place(entry{bucket,a,b,node});
+        ++nb_entries;
+    }
+
+    /**
+     * @brief Erase
+     *
+     * Remove the entry of a key, if any.
+     * The following entries of the probe sequence are shifted back into the emptied slot
+     * when their own probe sequence goes through it, so that no tombstone is needed.
+     */
+    void erase(unsigned a, unsigned b, uint64_t bucket) {
+        if(slots.empty()) {
+            return;
+        }
+        size_t i = home(a,b,bucket);
+        while(!(slots[i].bucket == bucket && slots[i].a == a && slots[i].b == b)) {
+            if(slots[i].node == UINT_MAX) {
+                return;
+            }
+            i = next(i);
+        }
+        if(slots[i].node == UINT_MAX) {
+            return;
+        }
+        size_t nb_slots = slots.size();
+        for(size_t j = next(i); slots[j].node != UINT_MAX; j = next(j)) {
+            size_t h = home(slots[j].a,slots[j].b,slots[j].bucket);
+            if((j + nb_slots - h) % nb_slots >= (j + nb_slots - i) % nb_slots) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i].node = UINT_MAX;
+        --nb_entries;
+    }
+
+private:
+    static uint64_t hash(unsigned a, unsigned b, uint64_t bucket) {
+        return mix64(bucket ^ mix64(((uint64_t) a << 32) | b));
+    }
+
+    /**
+     * @brief Home
+     *
+     * @return Return the first slot of the probe sequence of a key.
+     */
+    size_t home(unsigned a, unsigned b, uint64_t bucket) const {
+        return hash(a,b,bucket) % slots.size();
+    }
+
+    size_t next(size_t i) const {
+        return (i + 1 == slots.size()) ? 0 : i + 1;
+    }
+
+    void place(const entry &en) {
+        size_t i = home(en.a,en.b,en.bucket);
+        while(slots[i].node != UINT_MAX) {
+            i = next(i);
+        }
+        slots[i] = en;
+    }
+
+    /**
+     * @brief Rehash
+     *
+     * Move the entries to a table of the given number of slots.
+     */
+    void rehash(size_t nb_slots) {
+        std::vector<entry> old(nb_slots,entry{0,0,0,UINT_MAX});
+        old.swap(slots);
+        for(const entry &en : old) {
+            if(en.node != UINT_MAX) {
+                place(en);
+            }
+        }
+    }
+};
+
+#endif // NODE_INDEX_HPP_
@@ -0,0 +1,376 @@
+#ifndef SHARED_MCTS_TREE_HPP_
+#define SHARED_MCTS_TREE_HPP_
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <mcts_tree.hpp>
+
+/** @brief Number of locks shared by the nodes of a shared tree */
+constexpr unsigned NB_TREE_LOCKS = 1024;
+
+/**
+ * @brief Atomic add
+ *
+ * Add a value to an atomic double with a compare-and-swap loop.
+ */
+inline void atomic_add(std::atomic<double> &x, double y) {
+    double expected = x.load(std::memory_order_relaxed);
+    while(!x.compare_exchange_weak(expected,expected + y,std::memory_order_relaxed)) {}
+}
+
+/**
+ * @brief Shared MCTS tree class
+ *
+ * Search tree descended and grown concurrently by several threads, with the same layout as
+ * mcts_tree.
+ * The arrays are allocated once with a fixed capacity hence they are never reallocated
+ * during a search; nodes are allocated with atomic counters.
+ * The arrays are not initialized, so that the memory pages of unused nodes are not touched.
+ * A node is linked to its parent only once it is written, with a release store that the
+ * readers of the children lists acquire; children are inserted at the head of the lists.
+ * The visit counts and returns sums of the chance nodes are atomic.
+ * Expansions of a decision node and creations of a decision node below a chance node are
+ * serialized by a lock picked amongst NB_TREE_LOCKS wrt the node.
+ */
+class shared_mcts_tree {
+public:
+    const map_graph * graph_ptr; ///< Graph of the labelling states
+    double time_quantum; ///< Width of the time buckets of the successor states, 0 for exact times
+    const unsigned dnodes_capacity; ///< Maximum number of decision nodes
+    const unsigned cnodes_capacity; ///< Maximum number of chance nodes
+    const unsigned actions_capacity; ///< Maximum size of the actions pool
+    std::atomic<unsigned> nb_dnodes; ///< Number of decision nodes
+    std::atomic<unsigned> nb_cnodes; ///< Number of chance nodes
+    std::atomic<unsigned> actions_pool_size; ///< Size of the actions pool
+
+    // Decision nodes
+    std::unique_ptr<double[]> d_time; ///< Time of the labelling state
+    std::unique_ptr<unsigned[]> d_node_id; ///< Map node id of the labelling state
+    std::unique_ptr<unsigned[]> d_actions; ///< Indice of the first action in the actions pool
+    std::unique_ptr<unsigned[]> d_nb_actions; ///< Number of actions
+    std::unique_ptr<std::atomic<unsigned>[]> d_nb_children; ///< Number of children ie of expanded actions
+    std::unique_ptr<std::atomic<unsigned>[]> d_first_child; ///< First chance node child
+    std::unique_ptr<std::atomic<unsigned>[]> d_sibling; ///< Next decision node child of the same chance node
+
+    // Chance nodes
+    std::unique_ptr<unsigned[]> c_action; ///< Indice of the labelling action
+    std::unique_ptr<std::atomic<unsigned>[]> c_nb_visits; ///< Number of visits, including the ongoing ones
+    std::unique_ptr<std::atomic<double>[]> c_returns_sum; ///< Sum of the sampled returns and virtual losses
+    std::unique_ptr<std::atomic<unsigned>[]> c_first_child; ///< First decision node child
+    std::unique_ptr<std::atomic<unsigned>[]> c_sibling; ///< Next chance node child of the same decision node
+
+    std::unique_ptr<unsigned[]> actions_pool; ///< Actions of each decision node
+    std::array<std::mutex,NB_TREE_LOCKS> locks; ///< Locks of the nodes
+
+    /**
+     * @brief Constructor
+     *
+     * @param {unsigned} _dnodes_capacity; maximum number of decision nodes
+     * @param {unsigned} _cnodes_capacity; maximum number of chance nodes
+     * @param {unsigned} _actions_capacity; maximum size of the actions pool
+     */
+    shared_mcts_tree(
+        unsigned _dnodes_capacity,
+        unsigned _cnodes_capacity,
+        unsigned _actions_capacity) :
+        graph_ptr(nullptr),
+        time_quantum(0.),
+        dnodes_capacity(_dnodes_capacity),
+        cnodes_capacity(_cnodes_capacity),
+        actions_capacity(_actions_capacity),
+        nb_dnodes(0),
+        nb_cnodes(0),
+        actions_pool_size(0),
+        d_time(new double[_dnodes_capacity]),
+        d_node_id(new unsigned[_dnodes_capacity]),
+        d_actions(new unsigned[_dnodes_capacity]),
+        d_nb_actions(new unsigned[_dnodes_capacity]),
+        d_nb_children(new std::atomic<unsigned>[_dnodes_capacity]),
+        d_first_child(new std::atomic<unsigned>[_dnodes_capacity]),
+        d_sibling(new std::atomic<unsigned>[_dnodes_capacity]),
+        c_action(new unsigned[_cnodes_capacity]),
+        c_nb_visits(new std::atomic<unsigned>[_cnodes_capacity]),
+        c_returns_sum(new std::atomic<double>[_cnodes_capacity]),
+        c_first_child(new std::atomic<unsigned>[_cnodes_capacity]),
+        c_sibling(new std::atomic<unsigned>[_cnodes_capacity]),
+        actions_pool(new unsigned[_actions_capacity])
+    {}
+
+    unsigned get_nb_dnodes() const {
+        return nb_dnodes.load(std::memory_order_relaxed);
+    }
+
+    unsigned get_nb_cnodes() const {
+        return nb_cnodes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get number of bytes
+     *
+     * @return Return the number of bytes allocated by the tree, ie the capacities of its
+     * arrays, whether they hold nodes or not, and of its locks, as mcts_tree::get_nb_bytes.
+     */
+    size_t get_nb_bytes() const {
+        return (size_t) dnodes_capacity * (sizeof(double) + 3 * sizeof(unsigned) + 3 * sizeof(std::atomic<unsigned>))
+            + (size_t) cnodes_capacity * (sizeof(unsigned) + 3 * sizeof(std::atomic<unsigned>) + sizeof(std::atomic<double>))
+            + (size_t) actions_capacity * sizeof(unsigned)
+            + sizeof(locks);
+    }
+
+    /**
+     * @brief Clear
+     *
+     * Remove every node, the memory being kept for the next tree.
+     * @warning Not thread-safe.
+     */
+    void clear() {
+        nb_dnodes = 0;
+        nb_cnodes = 0;
+        actions_pool_size = 0;
+    }
+
+    /**
+     * @brief Get state
+     *
+     * @return Return the labelling state of a decision node.
+     */
+    state get_state(unsigned d) const {
+        return state(d_time[d],&graph_ptr->nodes_vector[d_node_id[d]]);
+    }
+
+    action get_action(unsigned c) const {
+        return action(c_action[c]);
+    }
+
+    unsigned get_nb_visits(unsigned c) const {
+        return c_nb_visits[c].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get value
+     *
+     * @return Return the mean of the sampled returns of a chance node, the ongoing visits
+     * counting as virtual losses.
+     */
+    double get_value(unsigned c) const {
+        unsigned nb_visits = get_nb_visits(c);
+        return (nb_visits == 0) ? 0. :
+            c_returns_sum[c].load(std::memory_order_relaxed) / ((double) nb_visits);
+    }
+
+    unsigned get_first_child(unsigned d) const {
+        return d_first_child[d].load(std::memory_order_acquire);
+    }
+
+    unsigned get_next_sibling(unsigned c) const {
+        return c_sibling[c].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get child
+     *
+     * @return Return the k-th chance node child of a decision node.
+     */
+    unsigned get_child(unsigned d, unsigned k) const {
+        unsigned c = get_first_child(d);
+        for(; k>0; --k) {
+            c = get_next_sibling(c);
+        }
+        return c;
+    }
+
+    /**
+     * @brief Get number of children
+     *
+     * @return Return the number of chance node children of a decision node, all of which
+     * are linked to it.
+     */
+    unsigned get_nb_children(unsigned d) const {
+        return d_nb_children[d].load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Is fully expanded
+     *
+     * Test whether every action of a decision node has been expanded.
+     */
+    bool is_fully_expanded(unsigned d) const {
+        return get_nb_children(d) == d_nb_actions[d];
+    }
+
+    /**
+     * @brief Add root
+     *
+     * @param {const state &} s; labelling state of the root
+     * @warning Not thread-safe, the tree must be empty.
+     */
+    void add_root(const state &s) {
+        graph_ptr = s.nd_ptr->graph_ptr;
+        create_dnode(s);
+    }
+
+    /**
+     * @brief Find or add decision node
+     *
+     * Find the decision node child of a chance node labelled by a state, create it if there
+     * is none.
+     * A created decision node is expanded before being linked to its parent, hence it is a
+     * leaf whose first child is only visible once the caller updates its value.
+     * Template method.
+     * @param {unsigned} c; parent chance node
+     * @param {const state &} s; labelling state
+     * @param {G &} generator; random number generator of the expansion
+     * @param {double} virtual_loss; virtual loss of the expansion, see expand
+     * @param {unsigned &} new_cnode; set to the child of the created decision node, NO_NODE
+     * if the decision node already existed
+     * @return Return the indice of the decision node.
+     */
+    template <class G>
+    unsigned find_or_add_dnode(
+        unsigned c,
+        const state &s,
+        G &generator,
+        double virtual_loss,
+        unsigned &new_cnode)
+    {
+        new_cnode = NO_NODE;
+        unsigned d = find_child(c,s);
+        if(d != NO_NODE) {
+            return d;
+        }
+        std::lock_guard<std::mutex> guard(get_cnode_lock(c));
+        d = find_child(c,s); // the child may have been created meanwhile
+        if(d == NO_NODE) {
+            d = create_dnode(s);
+            new_cnode = expand(d,generator,virtual_loss);
+            d_sibling[d].store(c_first_child[c].load(std::memory_order_relaxed),std::memory_order_relaxed);
+            c_first_child[c].store(d,std::memory_order_release);
+        }
+        return d;
+    }
+
+    /**
+     * @brief Expand
+     *
+     * Create a chance node child of a decision node, labelled by an action picked at
+     * random with the given generator amongst the ones not expanded yet.
+     * The chance node is created with an ongoing visit, see add_virtual_loss.
+     * Template method.
+     * @return Return the indice of the created chance node, NO_NODE if the decision node is
+     * fully expanded.
+     */
+    template <class G>
+    unsigned expand(unsigned d, G &generator, double virtual_loss) {
+        std::lock_guard<std::mutex> guard(get_dnode_lock(d));
+        unsigned k = d_nb_children[d].load(std::memory_order_relaxed);
+        if(k == d_nb_actions[d]) {
+            return NO_NODE;
+        }
+        unsigned c = nb_cnodes.fetch_add(1,std::memory_order_relaxed);
+        assert(c < cnodes_capacity);
+        unsigned * actions = &actions_pool[d_actions[d]];
+        unsigned i = uniform_integer(generator,k,d_nb_actions[d]-1);
+        std::swap(actions[k],actions[i]);
+        c_action[c] = actions[k];
+        c_nb_visits[c].store(1,std::memory_order_relaxed);
+        c_returns_sum[c].store(-virtual_loss,std::memory_order_relaxed);
+        c_first_child[c].store(NO_NODE,std::memory_order_relaxed);
+        c_sibling[c].store(d_first_child[d].load(std::memory_order_relaxed),std::memory_order_relaxed);
+        d_first_child[d].store(c,std::memory_order_release);
+        d_nb_children[d].store(k + 1,std::memory_order_release);
+        return c;
+    }
+
+    /**
+     * @brief Add virtual loss
+     *
+     * Count an ongoing visit of a chance node as a visit returning minus the virtual loss,
+     * to divert the other threads from it until the visit is over.
+     */
+    void add_virtual_loss(unsigned c, double virtual_loss) {
+        c_nb_visits[c].fetch_add(1,std::memory_order_relaxed);
+        atomic_add(c_returns_sum[c],-virtual_loss);
+    }
+
+    /**
+     * @brief Update value
+     *
+     * End an ongoing visit of a chance node by replacing its virtual loss with the sampled
+     * return.
+     * @param {unsigned} c; updated chance node
+     * @param {double} q; sampled return
+     * @param {double} virtual_loss; virtual loss of the visit
+     */
+    void update_value(unsigned c, double q, double virtual_loss) {
+        atomic_add(c_returns_sum[c],q + virtual_loss);
+    }
+
+    /**
+     * @brief Update value
+     *
+     * End an ongoing visit of a chance node by replacing its virtual loss with several
+     * sampled returns, the visit counting as the first one.
+     * @param {const running_statistics &} samples; sampled returns, at least one
+     * @param {double} virtual_loss; virtual loss of the visit
+     */
+    void update_value(unsigned c, const running_statistics &samples, double virtual_loss) {
+        c_nb_visits[c].fetch_add(samples.get_count() - 1,std::memory_order_relaxed);
+        atomic_add(c_returns_sum[c],samples.sum + virtual_loss);
+    }
+
+    /**
+     * @brief Find child
+     *
+     * @return Return the decision node child of a chance node whose state has the map node
+     * and the time bucket of a state, NO_NODE if there is none.
+     */
+    unsigned find_child(unsigned c, const state &s) const {
+        uint64_t bucket = get_time_bucket(s.t,time_quantum);
+        for(unsigned d = c_first_child[c].load(std::memory_order_acquire); d != NO_NODE;
+            d = d_sibling[d].load(std::memory_order_acquire)) {
+            if(d_node_id[d] == s.nd_ptr->id && get_time_bucket(d_time[d],time_quantum) == bucket) {
+                return d;
+            }
+        }
+        return NO_NODE;
+    }
+
+private:
+    std::mutex &get_dnode_lock(unsigned d) {
+        return locks[(2 * d) % NB_TREE_LOCKS];
+    }
+
+    std::mutex &get_cnode_lock(unsigned c) {
+        return locks[(2 * c + 1) % NB_TREE_LOCKS];
+    }
+
+    /**
+     * @brief Create decision node
+     *
+     * Write a new decision node, not linked to any parent.
+     * @return Return the indice of the created decision node.
+     */
+    unsigned create_dnode(const state &s) {
+        unsigned d = nb_dnodes.fetch_add(1,std::memory_order_relaxed);
+        assert(d < dnodes_capacity);
+        unsigned nb_actions = s.get_nb_actions();
+        unsigned first_action = actions_pool_size.fetch_add(nb_actions,std::memory_order_relaxed);
+        assert(first_action + nb_actions <= actions_capacity);
+        d_time[d] = s.t;
+        d_node_id[d] = s.nd_ptr->id;
+        d_actions[d] = first_action;
+        d_nb_actions[d] = nb_actions;
+        d_nb_children[d].store(0,std::memory_order_relaxed);
+        d_first_child[d].store(NO_NODE,std::memory_order_relaxed);
+        d_sibling[d].store(NO_NODE,std::memory_order_relaxed);
+        for(unsigned k=0; k<nb_actions; ++k) {
+            actions_pool[first_action + k] = k;
+        }
+        return d;
+    }
+};
+
+#endif // SHARED_MCTS_TREE_HPP_
@@ -0,0 +1,147 @@
+#ifndef UCT_SELECTION_HPP_
+#define UCT_SELECTION_HPP_
+
+#include <cmath>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <rng.hpp>
+#include <utils.hpp>
+
+/**
+ * @brief UCT selection
+ *
+ * Selection of the child of a decision node maximising the UCT score.
+ * The values and visit counts of the children are gathered into contiguous arrays, then
+ * the scores of the children are computed two at a time with SSE2 if it is available, and the
+ * maximum is found in a single pass, ties being broken uniformly by reservoir sampling.
+ * The packed square roots and divisions are correctly rounded, hence the scores are the
+ * same as the ones of the scalar loop.
+ * The arrays are kept between selections so that no allocation occurs once they reached the
+ * largest number of children.
+ */
+class uct_selection {
+public:
+    std::vector<unsigned> children; ///< Gathered chance nodes
+    std::vector<double> values; ///< Value of each gathered chance node
+    std::vector<double> nb_visits; ///< Number of visits of each gathered chance node
+    std::vector<double> scores; ///< UCT score of each gathered chance node
+
+    /**
+     * @brief Clear
+     *
+     * Clear the gathered children, keeping the memory.
+     */
+    void clear() {
+        children.clear();
+        values.clear();
+        nb_visits.clear();
+    }
+
+    /**
+     * @brief Add
+     *
+     * Gather a child of the decision node.
+     * @param {unsigned} c; chance node, visited at least once
+     * @param {double} value; value of the chance node
+     * @param {unsigned} n; number of visits of the chance node
+     */
+    void add(unsigned c, double value, unsigned n) {
+        children.push_back(c);
+        values.push_back(value);
+        nb_visits.push_back((double) n);
+    }
+
+    /**
+     * @brief Select
+     *
+     * Select the gathered child with the maximum UCT score.
+     * Template method.
+     * @param {double} uct_parameter; UCT parameter
+     * @param {double} nb_total_visits; count in the logarithm of the exploration term
+     * @param {G &} generator; random number generator breaking the ties
+     * @return Return the selected chance node.
+     */
+    template <class G>
+    unsigned select(double uct_parameter, double nb_total_visits, G &generator) {
+        unsigned nb_children = children.size();
+        scores.resize(nb_children);
+        const double exploration = 2. * uct_parameter;
+        const double log_nb_total_visits = log(nb_total_visits);
+        const double * v = values.data();
+        const double * n = nb_visits.data();
+        double * sc = scores.data();
+        unsigned k = 0;
+#ifdef __SSE2__
+        const __m128d exploration_pd = _mm_set1_pd(exploration);
+        const __m128d log_nb_total_visits_pd = _mm_set1_pd(log_nb_total_visits);
+        for(; k+1<nb_children; k+=2) {
+            __m128d ratio = _mm_div_pd(log_nb_total_visits_pd,_mm_loadu_pd(n + k));
+            __m128d bonus = _mm_mul_pd(exploration_pd,_mm_sqrt_pd(ratio));
+            _mm_storeu_pd(sc + k,_mm_add_pd(_mm_loadu_pd(v + k),bonus));
+        }
+#endif
+        for(; k<nb_children; ++k) {
+            sc[k] = v[k] + exploration * sqrt(log_nb_total_visits / n[k]);
+        }
+        return select_greatest(sc,generator);
+    }
+
+    /**
+     * @brief Select greatest value
+     *
+     * Select the gathered child with the maximum value, ties being broken as in 'select'.
+     * Template method.
+     * @param {G &} generator; random number generator breaking the ties
+     * @return Return the selected chance node.
+     */
+    template <class G>
+    unsigned select_greatest_value(G &generator) const {
+        return select_greatest(values.data(),generator);
+    }
+
+    /**
+     * @brief Select most visited
+     *
+     * Select the gathered child with the maximum number of visits, ties being broken as in
+     * 'select'. Template method.
+     * @param {G &} generator; random number generator breaking the ties
+     * @return Return the selected chance node.
+     */
+    template <class G>
+    unsigned select_most_visited(G &generator) const {
+        return select_greatest(nb_visits.data(),generator);
+    }
+
+private:
+    /**
+     * @brief Select greatest
+     *
+     * Select the gathered child with the maximum key in a single pass, ties being broken
+     * uniformly by reservoir sampling. Template method.
+     * @param {const double *} x; key of each gathered chance node
+     * @param {G &} generator; random number generator breaking the ties
+     * @return Return the selected chance node.
+     */
+    template <class G>
+    unsigned select_greatest(const double * x, G &generator) const {
+        unsigned best = 0;
+        unsigned nb_ties = 1;
+        for(unsigned k=1; k<children.size(); ++k) {
+            if(is_greater_than(x[k],x[best])) {
+                best = k;
+                nb_ties = 1;
+            } else if(!is_less_than(x[k],x[best])) { // tie, kept with probability 1/nb_ties
+                ++nb_ties;
+                if(uniform_integer(generator,0,nb_ties-1) == 0) {
+                    best = k;
+                }
+            }
+        }
+        return children[best];
+    }
+};
+
+#endif // UCT_SELECTION_HPP_
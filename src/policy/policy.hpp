@@ -4,6 +4,18 @@
 #include <state.hpp>
 #include <action.hpp>
 
+/**
+ * @brief Decision statistics
+ *
+ * Statistics of the last application of a policy.
+ */
+struct decision_statistics {
+    double duration; ///< Duration in microseconds
+    unsigned nb_iterations; ///< Number of iterations of the tree search, over every search thread
+    unsigned nb_calls; ///< Number of calls to the generative model, over every search thread
+    size_t peak_tree_bytes; ///< Peak number of bytes of the search trees, over every search thread
+};
+
 class policy {
 public:
     virtual ~policy() {}
@@ -15,6 +27,17 @@ public:
         const action &a,
         unsigned r,
         const state &s_p) = 0;
+
+    /**
+     * @brief Step
+     *
+     * Notify the policy that the agent moved to its observed successor state.
+     * @param {const action &} a; applied action
+     * @param {const state &} s_p; observed successor state
+     */
+    virtual void step(const action &a, const state &s_p) = 0;
+
+    virtual decision_statistics get_decision_statistics() const = 0;
 };
 
 #endif // POLICY_HPP_
@@ -6,7 +6,29 @@
 class random_policy : public policy {
 public:
     action apply(const state &s) override {
-        return rand_element(s.get_action_space());
+        unsigned nb_edges = s.get_nb_edges();
+        if(nb_edges > 0) {
+            return action(rand() % nb_edges);
+        } else {
+            return action(); // dead end, see state::get_action_space
+        }
+    }
+
+    /**
+     * @brief Apply the policy with the given generator
+     *
+     * Same as apply, without touching the global random state, hence usable concurrently
+     * with a generator per thread.
+     * Template method.
+     */
+    template <class G>
+    action apply(const state &s, G &generator) const {
+        unsigned nb_edges = s.get_nb_edges();
+        if(nb_edges > 0) {
+            return action(uniform_integer(generator,0,nb_edges-1));
+        } else {
+            return action(); // dead end, see state::get_action_space
+        }
     }
 
     void process_reward(
@@ -20,6 +42,15 @@ public:
         (void) s_p;
         /* Nothing to process for random policy */
     }
+
+    void step(const action &a, const state &s_p) override {
+        (void) a;
+        (void) s_p;
+    }
+
+    decision_statistics get_decision_statistics() const override {
+        return decision_statistics{0.,0,0,0}; // no search
+    }
 };
 
 #endif // RANDOM_POLICY_HPP_
@@ -27,12 +27,20 @@ public:
  * @brief Estimates history class
  *
  * Estimate history class associated to a state-action pair.
+ * The sufficient statistics of the polynomial regression of the values on the times of the
+ * node relatively to the root are updated as the estimates are added: with x such a time,
+ * y the value and phi = (1, x, ..., x^degree), phi^T phi only depends on the sums of the
+ * powers of x up to 2 * degree and phi^T y is made of the sums of y times the powers of x
+ * up to degree.
  */
 class estimates_history {
 public:
-    std::string location; ///< State
-    std::string direction; ///< Action
+    const map_node * location; ///< State
+    action direction; ///< Action
     std::vector<estimate> hist; ///< Associated history of estimates
+    unsigned degree; ///< Degree of the polynomial regression
+    std::vector<double> x_power_sums; ///< Sums of the powers 0 to 2 * degree of the relative times of the estimates
+    std::vector<double> xy_power_sums; ///< Sums of the values times the powers 0 to degree of the relative times
 
     /**
      * @brief Constructor
@@ -40,26 +48,39 @@ public:
      * Constructor adding one element to the history.
      */
     estimates_history(
-        const std::string &_location,
-        const std::string &_direction,
+        const map_node * _location,
+        const action &_direction,
+        unsigned _degree,
         double _t_root,
         double _t_node,
         double _value) :
         location(_location),
-        direction(_direction)
+        direction(_direction),
+        degree(_degree),
+        x_power_sums(2 * _degree + 1,0.),
+        xy_power_sums(_degree + 1,0.)
     {
         add_estimate(_t_root,_t_node,_value);
     }
 
-    estimates_history() {}
+    estimates_history() : location(nullptr), degree(0), x_power_sums(1,0.), xy_power_sums(1,0.) {}
 
     /**
      * @brief Add estimate
      *
-     * Add a new estimate to the state-action pair.
+     * Add a new estimate to the state-action pair and update the power sums.
      */
     void add_estimate(double _t_root, double _t_node, double _value) {
         hist.emplace_back(_t_root,_t_node,_value);
+        double x = _t_node - _t_root;
+        double xk = 1.;
+        for(unsigned k=0; k<=2*degree; ++k) {
+            x_power_sums[k] += xk;
+            if(k <= degree) {
+                xy_power_sums[k] += _value * xk;
+            }
+            xk *= x;
+        }
     }
 
     /**
@@ -69,8 +90,8 @@ public:
      */
     bool corresponds_to(const state &st, const action &ac) const {
         return (
-            (location.compare(st.get_name()) == 0) &&
-            (direction.compare(ac.direction) == 0)
+            (location == st.nd_ptr) &&
+            direction.is_equal_to(ac)
         );
     }
 
@@ -82,8 +103,8 @@ public:
     }
 
     void print() const {
-        std::cout << "loc: " << location << " ";
-        std::cout << "dir: " << direction << " ";
+        std::cout << "loc: " << location->name << " ";
+        std::cout << "dir: " << state(0.,location).get_direction(direction) << " ";
         std::cout << "hist:\n";
         for(auto &e : hist) {
             e.print();
@@ -91,4 +112,17 @@ public:
     }
 };
 
+/**
+ * @brief Regression cache
+ *
+ * Value prediction of a chance node regressed together with an estimates history, as an
+ * affine function of the sampled returns mean of the node.
+ */
+struct regression_cache {
+    double x; ///< Time of the node relatively to the root
+    size_t nb_estimates; ///< Size of the history when the prediction was solved, 0 if it was not yet
+    double intercept; ///< Prediction for a null returns mean
+    double slope; ///< Prediction increase per unit of returns mean
+};
+
 #endif // ESTIMATES_HISTORY_HPP_
@@ -1,56 +1,119 @@
 #ifndef TMP_MCTS_POLICY_HPP_
 #define TMP_MCTS_POLICY_HPP_
 
-#include <tmp_cnode.hpp>
-#include <tmp_dnode.hpp>
+#include <chrono>
+
 #include <environment.hpp>
 #include <estimates_history.hpp>
+#include <linear_algebra.hpp>
+#include <mcts_tree.hpp>
+#include <parallel.hpp>
 #include <random_policy.hpp>
+#include <uct_selection.hpp>
 #include <utils.hpp>
 
 class tmp_mcts_policy : public policy {
 public:
-    random_policy default_policy; ///< Default policy
     const environment * envt_ptr; ///< Generative model (pointer to the real environment)
     const bool is_model_dynamic; ///< Is the model dynamic
     const double discount_factor; ///< Discount factor
     const double uct_parameter; ///< UCT parameter
     const unsigned budget; ///< Budget ie number of expanded nodes in the tree
     const unsigned horizon; ///< Horizon for the default policy simulation
+    const unsigned nb_rollouts; ///< Number of default policy simulations at each evaluated leaf, averaged to lower the variance of its value
     const unsigned mcts_strategy_switch; ///< Strategy switch for MCTS algorithm
     const double regression_regularization;
     const unsigned polynomial_regression_degree;
+    const bool reuse_tree; ///< Keep the subtree of the observed successor state between applications
+    const unsigned nb_search_threads; ///< Number of threads of the root-parallel search
+    const unsigned time_limit; ///< Per-decision time limit of the search in microseconds, 0 for none
+    const unsigned calls_limit; ///< Per-decision limit on the generative model calls of each search thread, 0 for none
+    const double time_quantum; ///< Width of the time buckets merging the successor states of a chance node, 0 for exact times
+    const double widening_coefficient; ///< Progressive widening coefficient k, a chance node visited n times having at most k * n^alpha successors, 0 for none
+    const double widening_exponent; ///< Progressive widening exponent alpha
+    const bool share_transpositions; ///< Share the decision nodes with the same map node and time bucket between the paths of the tree
+    const size_t tree_memory_limit; ///< Limit on the bytes allocated by the tree of each search thread, pruned before it outgrows them, 0 for none
 
     std::list<estimates_history> eh_container; ///< Estimates history container
+    const tmp_mcts_policy * eh_owner; ///< Policy whose estimates histories are used, itself unless it is a search worker
     double reference_time; ///< Initial time of the state at which the policy is applied
     unsigned nb_calls; ///< Number of calls to the generative model
     unsigned nb_tmp_cnodes; ///< Number of expanded chance nodes
+    unsigned nb_iterations; ///< Number of iterations of the last search of the thread
+    size_t peak_tree_bytes; ///< Peak number of bytes of the tree during the last search of the thread
+    std::chrono::steady_clock::time_point deadline; ///< Deadline of the current search
+    decision_statistics last_decision; ///< Statistics of the last application of the policy
+    mcts_tree tree; ///< Search tree, rebuilt or re-rooted at each application of the policy
+    std::vector<const estimates_history *> cnodes_eh; ///< Estimates history of each chance node, if any when it was created
+    std::vector<regression_cache> cnodes_regression; ///< Cached value regression of each chance node with an estimates history
+    xoshiro_rng rng; ///< Random number generator of the search, reseeded at each application
+    std::vector<path_step> path; ///< Visited chance nodes of the current iteration, kept between iterations
+    std::vector<double> rollout_returns; ///< Returns of the rollouts of the evaluated leaf
+    uct_selection selection; ///< Children gathered by the UCT strategy, kept between selections
+    std::vector<std::unique_ptr<tmp_mcts_policy>> workers; ///< Policies building the trees of the other search threads
 
     /**
      * @brief Constructor
      */
     tmp_mcts_policy(
-        environment * _envt_ptr,
+        const environment * _envt_ptr,
         bool _is_model_dynamic,
         double _discount_factor,
         double _uct_parameter,
         unsigned _budget,
         unsigned _horizon,
+        unsigned _nb_rollouts,
         unsigned _mcts_strategy_switch,
         double _regression_regularization,
-        double _polynomial_regression_degree) :
+        double _polynomial_regression_degree,
+        bool _reuse_tree,
+        unsigned _nb_search_threads,
+        unsigned _time_limit,
+        unsigned _calls_limit,
+        double _time_quantum,
+        double _widening_coefficient,
+        double _widening_exponent,
+        bool _share_transpositions,
+        double _tree_memory_limit) :
         envt_ptr(_envt_ptr),
         is_model_dynamic(_is_model_dynamic),
         discount_factor(_discount_factor),
         uct_parameter(_uct_parameter),
         budget(_budget),
         horizon(_horizon),
+        nb_rollouts(std::max(_nb_rollouts,1u)),
         mcts_strategy_switch(_mcts_strategy_switch),
         regression_regularization(_regression_regularization),
-        polynomial_regression_degree(_polynomial_regression_degree)
+        polynomial_regression_degree(_polynomial_regression_degree),
+        reuse_tree(_reuse_tree),
+        nb_search_threads(get_nb_threads(_nb_search_threads)),
+        time_limit(_time_limit),
+        calls_limit(_calls_limit),
+        time_quantum(_time_quantum),
+        widening_coefficient(_widening_coefficient),
+        widening_exponent(_widening_exponent),
+        share_transpositions(_share_transpositions),
+        tree_memory_limit((size_t) (_tree_memory_limit * 1e6)),
+        eh_owner(this),
+        rng(0,0),
+        rollout_returns(nb_rollouts)
     {
         nb_calls = 0;
         nb_tmp_cnodes = 0;
+        nb_iterations = 0;
+        peak_tree_bytes = 0;
+        last_decision = decision_statistics{0.,0,0,0};
+        tree.time_quantum = time_quantum;
+        tree.share_transpositions = share_transpositions;
+        for(unsigned k=1; k<nb_search_threads; ++k) {
+            workers.emplace_back(new tmp_mcts_policy(
+                envt_ptr, is_model_dynamic, discount_factor, uct_parameter, budget, horizon,
+                nb_rollouts, mcts_strategy_switch, regression_regularization,
+                polynomial_regression_degree, reuse_tree, 1, time_limit, calls_limit, time_quantum,
+                widening_coefficient, widening_exponent, share_transpositions, _tree_memory_limit
+            ));
+            workers.back()->eh_owner = this;
+        }
     }
 
 //// COPY OF MCTS_POLICY ////////////////////////////////////////////////////////////////////
@@ -80,40 +143,57 @@ public:
     /**
      * @brief Sample return
      *
-     * Sample a return with the default policy starting at the input state.
-     * @param {state} s; input state
+     * Sample a return with the default policy starting at the input state and action.
+     * The default policy being uniformly random, the simulation is run by the rollout kernel
+     * of the environment, each of its transitions counting as a generative model call.
+     * @param {const state &} s; input state
+     * @param {const action &} a; first action
      * @return Return the sampled return.
      */
-    double sample_return(tmp_cnode * ptr) {
-        if(envt_ptr->is_state_terminal(ptr->s)) {
-            return envt_ptr->get_terminal_reward(ptr->s);
-        }
-        double total_return = 0.;
-        state s = ptr->s;
-        action a = ptr->a;
-        for(unsigned t=0; t<horizon; ++t) {
-            state s_p;
-            double r = 0.;
-            generative_model(s,a,r,s_p);
-            total_return += pow(discount_factor,(double)t) * r;
-            if(envt_ptr->is_state_terminal(s_p)) {
-                break;
-            }
-            s = s_p;
-            a = default_policy.apply(s);
+    double sample_return(const state &s, const action &a) {
+        if(envt_ptr->is_state_terminal(s)) {
+            return envt_ptr->get_terminal_reward(s);
+        }
+        return envt_ptr->rollout(
+            s.nd_ptr->id, s.t, a.indice, is_model_dynamic, reference_time, discount_factor,
+            horizon, rng, nb_calls
+        );
+    }
+
+    /**
+     * @brief Sample returns
+     *
+     * Sample nb_rollouts returns with the default policy starting at the input state and
+     * action, several rollouts being simulated as a batch, see environment::batch_rollout.
+     * @param {const state &} s; input state
+     * @param {const action &} a; first action
+     * @return Return the statistics of the sampled returns.
+     */
+    running_statistics sample_returns(const state &s, const action &a) {
+        running_statistics samples;
+        if(nb_rollouts == 1 || envt_ptr->is_state_terminal(s)) {
+            samples.add(sample_return(s,a));
+            return samples;
+        }
+        envt_ptr->batch_rollout(
+            s.nd_ptr->id, s.t, a.indice, is_model_dynamic, reference_time, discount_factor,
+            horizon, rng, nb_rollouts, rollout_returns.data(), nb_calls
+        );
+        for(double q : rollout_returns) {
+            samples.add(q);
         }
-        return total_return;
+        return samples;
     }
 
     /**
      * @brief Update value
      *
-     * Update the value of a chance node by stacking a new sampled value.
-     * @param {tmp_cnode *} ptr; pointer to the updated chance node
+     * Update the value of a chance node by adding a new sampled value to its statistics.
+     * @param {unsigned} c; updated chance node
      * @param {double} q; new sampled value
      */
-    void update_value(tmp_cnode * ptr, double q) const {
-        ptr->sampled_returns.push_back(q);
+    void update_value(unsigned c, double q) {
+        tree.c_returns[c].add(q);
     }
 
     /**
@@ -121,30 +201,11 @@ public:
      *
      * Select child of a decision node wrt the MCTS strategy.
      * The node must be fully expanded.
-     * @param {tmp_dnode *} v; decision node
+     * @param {unsigned} v; decision node
      * @return Return to the select child, which is a chance node.
      */
-    tmp_cnode * mcts_strategy(tmp_dnode * v) const {
-        return v->children.at(rand_indice(v->children)).get();
-    }
-
-    /**
-     * @brief UCT scores
-     *
-     * Compute the UCT scores of the given vector of chance nodes.
-     * @param {const std::vector<std::unique_ptr<tmp_cnode>> &} cv; input vector
-     * @return Return a vector containing the scores of the given vector of chance nodes.
-     */
-    std::vector<double> uct_scores(const std::vector<std::unique_ptr<tmp_cnode>> &cv) const {
-        std::vector<double> scores;
-        for(auto &c : cv) {
-            scores.emplace_back(
-                c->get_value()
-                + 2 * uct_parameter *
-                sqrt(log((double) nb_tmp_cnodes) / ((double) c->get_nb_visits()))
-            );
-        }
-        return scores;
+    unsigned mcts_strategy(unsigned v) {
+        return tree.get_child(v,uniform_integer(rng,0,tree.d_nb_children[v]-1));
     }
 
     /**
@@ -152,11 +213,15 @@ public:
      *
      * Select child of a decision node wrt the UCT strategy.
      * The node must be fully expanded.
-     * @param {tmp_dnode *} v; decision node
+     * @param {unsigned} v; decision node
      * @return Return to the select child, which is a chance node.
      */
-    tmp_cnode * uct_strategy(tmp_dnode * v) const {
-        return v->children.at(argmax(uct_scores(v->children))).get();
+    unsigned uct_strategy(unsigned v) {
+        selection.clear();
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            selection.add(c,get_value(v,c),tree.get_nb_visits(c));
+        }
+        return selection.select(uct_parameter,(double) nb_tmp_cnodes,rng);
     }
 
     /**
@@ -164,10 +229,10 @@ public:
      *
      * Select child of a decision node wrt one of the implemented strategies.
      * The node must be fully expanded.
-     * @param {tmp_dnode *} v; decision node
+     * @param {unsigned} v; decision node
      * @return Return to the select child, which is a chance node.
      */
-    tmp_cnode * select_child(tmp_dnode * v) const {
+    unsigned select_child(unsigned v) {
         switch(mcts_strategy_switch) {
             case 0: { // Vanilla MCTS
                 return mcts_strategy(v);
@@ -182,127 +247,176 @@ public:
     }
 
     /**
-     * @brief Is state already sampled
+     * @brief Is widening capped
      *
-     * Equality operator.
-     * @param {tmp_cnode *} ptr; pointer to the chance node
-     * @param {state &} s; sampled state
-     * @param {unsigned &} ind; indice modified to the value of the indice of the existing
-     * decision node with state s if the comparison succeeds.
+     * Test whether progressive widening forbids a new successor below a chance node, ie
+     * whether it has at least k * n^alpha successors, n being its number of visits.
+     * @param {unsigned} c; chance node
      */
-    bool is_state_already_sampled(tmp_cnode * ptr, state &s, unsigned &ind) const {
-        for(unsigned i=0; i<ptr->children.size(); ++i) {
-            if(s.is_equal_to(ptr->children[i]->s)) {
-                ind = i;
-                return true;
-            }
-        }
-        return false;
+    bool is_widening_capped(unsigned c) const {
+        return widening_coefficient > 0.
+            && tree.c_first_child[c] != NO_NODE
+            && (double) tree.get_nb_successors(c)
+            >= widening_coefficient * pow((double) tree.get_nb_visits(c),widening_exponent);
     }
 
     /**
      * @brief Search tree
      *
      * Search within the tree, starting from the input decision node.
-     * Recursive method.
-     * @param {tmp_dnode *} v; input decision node
+     * The tree is descended down to a leaf node, which is evaluated, then the sampled
+     * returns are backpropagated along the visited chance nodes, stored in the path buffer.
+     * A chance node whose successors are capped by progressive widening is descended through
+     * one of its successors instead of sampling a transition.
+     * @param {unsigned} v; input decision node
      * @return Return the sampled return at the given decision node
      */
-    double search_tree(tmp_dnode * v) {
-        if(envt_ptr->is_state_terminal(v->s)) { // terminal node
-            return envt_ptr->get_terminal_reward(v->s);
-        } else if(!v->is_fully_expanded()) { // leaf node, expand it
-            return evaluate(v);
-        } else { // apply tree policy
-            tmp_cnode * ptr = select_child(v);
+    double search_tree(unsigned v) {
+        path.clear();
+        double q = 0.;
+        while(true) {
+            state s = tree.get_state(v);
+            if(envt_ptr->is_state_terminal(s)) { // terminal node
+                q = envt_ptr->get_terminal_reward(s);
+                break;
+            } else if(!tree.is_fully_expanded(v)) { // leaf node, expand it
+                q = evaluate(v);
+                break;
+            }
+            unsigned c = select_child(v); // apply tree policy
+            if(is_widening_capped(c)) { // revisit a successor instead of sampling one
+                v = tree.sample_successor(c,rng);
+                ++tree.d_nb_visits[v];
+                path.push_back(path_step{c,envt_ptr->reward_function(tree.get_state(v))});
+                continue;
+            }
             state s_p;
             double r = 0.;
-            generative_model(v->s,ptr->a,r,s_p);
-            double q = 0.;
-            unsigned ind = 0; // indice of resulting child
-            if(is_state_already_sampled(ptr,s_p,ind)) { // go to node
-                q = r + discount_factor * search_tree(ptr->children.at(ind).get());
-            } else { // leaf node, create a new node
-                ptr->children.emplace_back(std::unique_ptr<tmp_dnode>(
-                    new tmp_dnode(s_p,ptr->depth+1)
-                ));
-                q = r + discount_factor * evaluate(ptr->get_last_child());
+            generative_model(s,tree.get_action(c),r,s_p);
+            path.push_back(path_step{c,r});
+            v = tree.find_successor(v,c,s_p);
+            if(v == NO_NODE) { // leaf node, create a new node
+                q = evaluate(tree.add_dnode(s_p,c));
+                break;
             }
-            update_value(ptr,q);
-            return q;
+            ++tree.d_nb_visits[v];
         }
+        for(auto it = path.rbegin(); it != path.rend(); ++it) { // backpropagate
+            q = it->r + discount_factor * q;
+            update_value(it->c,q);
+        }
+        return q;
+    }
+
+    /**
+     * @brief Is search over
+     *
+     * Test whether the search of the thread must stop: either the budget is spent, the
+     * deadline is passed or the generative model was called too many times.
+     * @param {unsigned} first_call; number of calls to the generative model when the search
+     * started
+     */
+    bool is_search_over(unsigned first_call) const {
+        return nb_iterations >= budget
+            || (calls_limit > 0 && nb_calls - first_call >= calls_limit)
+            || (time_limit > 0 && std::chrono::steady_clock::now() >= deadline);
+    }
+
+    /**
+     * @brief Get number of tree bytes
+     *
+     * @return Return the number of bytes allocated by the tree and the per chance node
+     * estimates histories pointers and regressions, see mcts_tree::get_nb_bytes.
+     */
+    size_t get_nb_tree_bytes() const {
+        return tree.get_nb_bytes()
+            + cnodes_eh.capacity() * sizeof(const estimates_history *)
+            + cnodes_regression.capacity() * sizeof(regression_cache);
     }
 
     /**
      * @brief Build tree
      *
-     * Build a tree at the input node.
-     * @param {tmp_dnode &} v; reference to the input node
+     * Build a tree at the root node.
+     * At least one iteration is run so that the root has a child to recommend.
+     * If the tree has a memory limit, its arrays are reserved within the limit, see
+     * set_root, and before an iteration that could outgrow them the tree is pruned down to
+     * TREE_PRUNING_TARGET of its nodes; the search stops if it cannot be, the nodes that are
+     * never pruned filling the memory.
      */
-    void build_tree(tmp_dnode &v) {
-        for(unsigned i=0; i<budget; ++i) {
-            search_tree(&v);
-        }
+    void build_tree() {
+        unsigned first_call = nb_calls;
+        nb_iterations = 0;
+        peak_tree_bytes = get_nb_tree_bytes();
+        do {
+            if(tree_memory_limit > 0 && !tree.has_room() && !tree.prune(TREE_PRUNING_TARGET) && nb_iterations > 0) {
+                break;
+            }
+            search_tree(0);
+            ++nb_iterations;
+            peak_tree_bytes = std::max(peak_tree_bytes,get_nb_tree_bytes());
+        } while(!is_search_over(first_call));
         nb_tmp_cnodes = 0;
     }
 
     /**
      * @brief Argmax value
      *
-     * Get the indice of the child with the maximum value.
-     * @param {const tmp_dnode &} v; input decision node
-     * @return Return the indice of the child with the maximum value.
+     * Get the child with the maximum value, ties being broken with the random number generator.
+     * @param {unsigned} v; input decision node
+     * @return Return the chance node with the maximum value.
      */
-    unsigned argmax_value(const tmp_dnode &v) const {
-        std::vector<double> values;
-        for(auto &c: v.children) {
-            values.emplace_back(c->get_value());
+    unsigned argmax_value(unsigned v) {
+        selection.clear();
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            selection.add(c,get_value(v,c),tree.get_nb_visits(c));
         }
-        return argmax(values);
+        return selection.select_greatest_value(rng);
     }
 
     /**
      * @brief Argmax visit counter
      *
-     * Get the indice of the child with the maximum number of visits.
-     * @param {const tmp_dnode &} v; input decision node
-     * @return Return the indice of the child with the maximum number of visits.
+     * Get the child with the maximum number of visits, ties being broken with the random
+     * number generator.
+     * @param {unsigned} v; input decision node
+     * @return Return the chance node with the maximum number of visits.
      */
-    unsigned argmax_nb_visits(const tmp_dnode &v) const {
-        std::vector<unsigned> nb_visits;
-        for(auto &c: v.children) {
-            nb_visits.emplace_back(c->get_nb_visits());
+    unsigned argmax_nb_visits(unsigned v) {
+        selection.clear();
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            selection.add(c,get_value(v,c),tree.get_nb_visits(c));
         }
-        return argmax(nb_visits);
+        return selection.select_most_visited(rng);
     }
 
     /**
      * @brief Recommended action
      *
      * Get the recommended action from an input decision node.
-     * @param {const tmp_dnode &} v; input decision node
+     * @param {unsigned} v; input decision node
      * @return Return the recommended action at the input decision node.
      */
-    action recommended_action(const tmp_dnode &v) {
-        //return v.children.at(argmax_nb_visits(v))->a; // higher number of visits
-        return v.children.at(argmax_value(v))->a; // higher value
+    action recommended_action(unsigned v) {
+        //return tree.get_action(argmax_nb_visits(v)); // higher number of visits
+        return tree.get_action(argmax_value(v)); // higher value
     }
 
-    void print_tree(const tmp_dnode &v) const {
-        std::cout << "Root : " << v.s.get_name() << std::endl;
+    void print_tree(unsigned v) const {
+        std::cout << "Root : " << tree.get_state(v).get_name() << std::endl;
         std::cout << "d1   : ";
-        for(auto &cn_ch : v.children) {
-            for(auto &dn_ch : cn_ch->children) {
-                std::cout << dn_ch->s.get_name() << "(" << cn_ch->s.get_name() << ") ";
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            for(unsigned d = tree.c_first_child[c]; d != NO_NODE; d = tree.d_sibling[d]) {
+                std::cout << tree.get_state(d).get_name() << "(" << tree.get_state(v).get_name() << ") ";
             }
         }
         std::cout << std::endl;
         std::cout << "d2   : ";
-        for(auto &cn_ch : v.children) {
-            for(auto &dn_ch : cn_ch->children) {
-                for(auto &a : dn_ch->children) {
-                    for(auto &b : a->children) {
-                        std::cout << b->s.get_name() << "(" << a->s.get_name() << ") ";
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            for(unsigned d = tree.c_first_child[c]; d != NO_NODE; d = tree.d_sibling[d]) {
+                for(unsigned a = tree.d_first_child[d]; a != NO_NODE; a = tree.c_sibling[a]) {
+                    for(unsigned b = tree.c_first_child[a]; b != NO_NODE; b = tree.d_sibling[b]) {
+                        std::cout << tree.get_state(b).get_name() << "(" << tree.get_state(d).get_name() << ") ";
                     }
                 }
             }
@@ -312,27 +426,26 @@ public:
 
 //// END COPY OF MCTS_POLICY ////////////////////////////////////////////////////////////////
 
-    void print_tree_hist(const tmp_dnode &v) const {
-        std::cout << "ROOT : " << v.s.get_name() << std::endl;
+    void print_cnode_hist(unsigned v, unsigned c) const {
+        if(cnodes_eh[c] == nullptr) {
+            std::cout << "nullptr (s: " << tree.get_state(v).get_name();
+            std::cout << " a: " << tree.get_state(v).get_direction(tree.get_action(c)) << ")\n";
+        } else {
+            cnodes_eh[c]->print();
+        }
+    }
+
+    void print_tree_hist(unsigned v) const {
+        std::cout << "ROOT : " << tree.get_state(v).get_name() << std::endl;
         std::cout << "d0   :\n";
-        for(auto &cn_ch : v.children) {
-            if(cn_ch->eh_ptr == nullptr) {
-                std::cout << "nullptr (s: " << cn_ch->s.get_name();
-                std::cout << " a: " << cn_ch->a.direction << ")\n";
-            } else {
-                cn_ch->eh_ptr->print();
-            }
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            print_cnode_hist(v,c);
         }
         std::cout << "d1   :\n";
-        for(auto &cn_ch : v.children) {
-            for(auto &dn_ch : cn_ch->children) {
-                for(auto &a : dn_ch->children) {
-                    if(a->eh_ptr == nullptr) {
-                        std::cout << "nullptr (s: " << a->s.get_name();
-                        std::cout << " a: " << a->a.direction << ")\n";
-                    } else {
-                        a->eh_ptr->print();
-                    }
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            for(unsigned d = tree.c_first_child[c]; d != NO_NODE; d = tree.d_sibling[d]) {
+                for(unsigned a = tree.d_first_child[d]; a != NO_NODE; a = tree.c_sibling[a]) {
+                    print_cnode_hist(d,a);
                 }
             }
         }
@@ -349,46 +462,178 @@ public:
         (void) s_p;
     }
 
+    /**
+     * @brief Is tree reused
+     *
+     * The tree is only reused with a dynamic model since the transitions of a static model
+     * depend on the time of the root.
+     */
+    bool is_tree_reused() const {
+        return reuse_tree && is_model_dynamic;
+    }
+
+    /**
+     * @brief Step
+     *
+     * If the tree is reused, re-root it at the decision node matching the observed successor
+     * state, the rest of the tree being freed; else or if there is no such node, clear it.
+     * @param {const action &} a; applied action
+     * @param {const state &} s_p; observed successor state
+     */
+    void step(const action &a, const state &s_p) override {
+        for(auto &w : workers) {
+            w->step(a,s_p);
+        }
+        if(!is_tree_reused() || tree.get_nb_dnodes() == 0) {
+            return;
+        }
+        unsigned c = tree.find_action(0,a);
+        unsigned d = (c == NO_NODE) ? NO_NODE : tree.find_successor(0,c,s_p);
+        if(d == NO_NODE) {
+            tree.clear();
+            cnodes_eh.clear();
+            cnodes_regression.clear();
+        } else {
+            std::vector<const estimates_history *> kept_eh;
+            for(unsigned origin : tree.reroot(d)) {
+                kept_eh.push_back(cnodes_eh[origin]);
+            }
+            cnodes_eh = std::move(kept_eh);
+            cnodes_regression.assign(cnodes_eh.size(),regression_cache());
+        }
+    }
+
+    /**
+     * @brief Get a pointer to the corresponding estimates history
+     *
+     * @param {const state &} st; state
+     * @param {const action &} ac; action
+     * @return Return a pointer to the estimates history of the state-action pair, nullptr
+     * if there is none.
+     */
+    const estimates_history * get_ptr_to_eh(const state &st, const action &ac) const {
+        for(auto &eh : eh_owner->eh_container) {
+            if(eh.corresponds_to(st,ac)) {
+                return &eh;
+            }
+        }
+        return nullptr; // no match
+    }
+
+    /**
+     * @brief Polynomial value prediction
+     *
+     * Predict the value of a chance node at the current root time by regressing its sampled
+     * returns mean together with its estimates history.
+     * The prediction, ie the constant coefficient of the regression, is linear in the returns
+     * mean: it is an intercept plus a slope times the mean, both solved from the power sums
+     * of the history and cached until an estimate is added or the time of the node relatively
+     * to the root changes.
+     * @param {unsigned} v; parent decision node of the chance node
+     * @param {unsigned} c; chance node
+     */
+    double polynomial_value_prediction(unsigned v, unsigned c) {
+        double x = tree.d_time[v] - reference_time;
+        const estimates_history &eh = *cnodes_eh[c];
+        regression_cache &rc = cnodes_regression[c];
+        if(rc.nb_estimates != eh.hist.size() || rc.x != x) {
+            assert(eh.degree == polynomial_regression_degree);
+            unsigned n = polynomial_regression_degree + 1;
+            std::vector<double> x_powers(2 * n - 1);
+            double xk = 1.;
+            for(double &p : x_powers) {
+                p = xk;
+                xk *= x;
+            }
+            Eigen::MatrixXd a(n,n);
+            Eigen::MatrixXd b(n,2); // right hand sides of the history and of the returns mean
+            for(unsigned i=0; i<n; ++i) {
+                for(unsigned j=0; j<n; ++j) {
+                    a(i,j) = eh.x_power_sums[i+j] + x_powers[i+j];
+                }
+                a(i,i) += regression_regularization;
+                b(i,0) = eh.xy_power_sums[i];
+                b(i,1) = x_powers[i];
+            }
+            Eigen::MatrixXd coeff = solve_normal_equations(a,b);
+            rc = regression_cache{x,eh.hist.size(),coeff(0,0),coeff(0,1)};
+        }
+        return rc.intercept + rc.slope * tree.get_value(c);
+    }
+
+    /**
+     * @brief Get the value estimate
+     *
+     * @param {unsigned} v; parent decision node of the chance node
+     * @param {unsigned} c; chance node
+     */
+    double get_value(unsigned v, unsigned c) {
+        if(cnodes_eh[c] == nullptr) {
+            return tree.get_value(c);
+        } else {
+            return polynomial_value_prediction(v,c);
+        }
+    }
+
+    /**
+     * @brief Attach estimates history
+     *
+     * Attach an estimates history to a created chance node, whose slot may be a recycled
+     * one of a pruned chance node.
+     */
+    void attach_eh(unsigned c, const estimates_history * eh) {
+        if(c >= cnodes_eh.size()) {
+            cnodes_eh.resize(c + 1,nullptr);
+            cnodes_regression.resize(c + 1);
+        }
+        cnodes_eh[c] = eh;
+        cnodes_regression[c].nb_estimates = 0; // not computed yet
+    }
+
     /**
      * @brief Evaluate
      *
-     * Create a new child node to a decision node and sample a return value with the default
-     * policy.
-     * @param {tmp_dnode *} v; pointer to the decision node
-     * @return Return the sampled value.
+     * Create a new child node to a decision node and sample nb_rollouts return values with
+     * the default policy, all of them being added to the child's statistics.
+     * The estimates history of the state-action pair of the child, if any, is attached to it.
+     * @param {unsigned} v; decision node
+     * @return Return the mean sampled value.
      */
-    double evaluate(tmp_dnode * v) {
+    double evaluate(unsigned v) {
         nb_tmp_cnodes++; // a chance node will be created
-        v->create_child(
-            eh_container,
-            reference_time,
-            regression_regularization,
-            polynomial_regression_degree
-        );
-        double q = sample_return(v->children.back().get());
-        update_value(v->children.back().get(),q);
-        return q;
+        unsigned c = tree.expand(v,rng);
+        state s = tree.get_state(v);
+        attach_eh(c,get_ptr_to_eh(s,tree.get_action(c)));
+        running_statistics samples = sample_returns(s,tree.get_action(c));
+        tree.c_returns[c].merge(samples);
+        return samples.get_mean();
     }
 
     /**
      * @brief Add chance node estimate
+     *
+     * @param {unsigned} v; parent decision node of the chance node
+     * @param {unsigned} c; chance node
      */
-    void update_eh_from_cn(tmp_cnode * cnp) {
+    void update_eh_from_cn(unsigned v, unsigned c) {
+        state s = tree.get_state(v);
+        action a = tree.get_action(c);
         bool match = false;
         for(auto &eh : eh_container) {
-            if(eh.corresponds_to(cnp->s,cnp->a)) {
-                eh.add_estimate(reference_time,cnp->s.t,cnp->get_sampled_returns_mean());
+            if(eh.corresponds_to(s,a)) {
+                eh.add_estimate(reference_time,s.t,tree.get_value(c));
                 match = true;
                 break;
             }
         }
         if(!match) {
             eh_container.emplace_back(
-                cnp->s.get_name(),
-                cnp->a.direction,
+                s.nd_ptr,
+                a,
+                polynomial_regression_degree,
                 reference_time,
-                cnp->s.t,
-                cnp->get_sampled_returns_mean()
+                s.t,
+                tree.get_value(c)
             );
         }
     }
@@ -396,24 +641,119 @@ public:
     /**
      * @brief Update estimate histories
      */
-    void update_eh(tmp_dnode * dnp) {
-        for(auto &ch : dnp->children) {
-            update_eh_from_cn(ch.get());
-            for(auto &e : ch->children) {
-                update_eh(e.get());
+    void update_eh(unsigned v) {
+        for(unsigned c = tree.d_first_child[v]; c != NO_NODE; c = tree.c_sibling[c]) {
+            update_eh_from_cn(v,c);
+            for(unsigned d = tree.c_first_child[c]; d != NO_NODE; d = tree.d_sibling[d]) {
+                update_eh(d);
             }
         }
     }
 
+    /**
+     * @brief Set root
+     *
+     * Set the root of the tree at the input state.
+     * The tree of the previous application is cleared and the new tree is built in the
+     * same memory, unless it is reused and was re-rooted at a decision node the input state
+     * is merged into, ie with its map node and time bucket; the root then keeps the time of
+     * the first state merged into it, as any merged node.
+     * If the tree has a memory limit, its arrays are reserved for as many nodes as fit in it.
+     */
+    void set_root(const state &s) {
+        reference_time = s.t;
+        if(tree_memory_limit > 0) {
+            tree.reserve_memory(
+                tree_memory_limit,
+                std::max(envt_ptr->graph->get_max_nb_edges(),1u),
+                sizeof(const estimates_history *) + sizeof(regression_cache)
+            );
+            cnodes_eh.reserve(tree.c_action.capacity());
+            cnodes_regression.reserve(tree.c_action.capacity());
+        }
+        if(!is_tree_reused() || tree.get_nb_dnodes() == 0 || !tree.is_merged_into(0,s)) {
+            tree.clear();
+            cnodes_eh.clear();
+            cnodes_regression.clear();
+            tree.add_dnode(s);
+        }
+        nb_tmp_cnodes = tree.get_nb_cnodes();
+    }
+
+    /**
+     * @brief Merge root statistics
+     *
+     * Merge the sampled returns statistics of the root's children of another tree into the
+     * ones of the tree, creating the children that do not exist yet.
+     * @param {const mcts_tree &} t; merged tree, with the same root
+     */
+    void merge_root_statistics(const mcts_tree &t) {
+        for(unsigned c = t.d_first_child[0]; c != NO_NODE; c = t.c_sibling[c]) {
+            unsigned m = tree.find_action(0,t.get_action(c));
+            if(m == NO_NODE) {
+                m = tree.expand_action(0,t.get_action(c));
+                attach_eh(m,get_ptr_to_eh(tree.get_state(0),t.get_action(c)));
+            }
+            tree.c_returns[m].merge(t.c_returns[c]);
+        }
+    }
+
+    /**
+     * @brief Get search thread
+     *
+     * @return Return the policy running the k-th search thread, the first one being this
+     * policy and the other ones its workers.
+     */
+    tmp_mcts_policy * get_search_thread(unsigned k) {
+        return (k == 0) ? this : workers[k-1].get();
+    }
+
     /**
      * @brief Apply the policy
+     *
+     * Each iteration creates at most one decision and one chance node.
+     * If the tree is reused and was re-rooted at the input state, the budget is spent on
+     * top of the kept subtree.
+     * With several search threads, each one builds its own tree with its own random stream
+     * and the statistics of the root's children are merged before updating the estimates
+     * histories and recommending an action.
+     * Every search thread stops at the first of its budget, the per-decision deadline or its
+     * limit on generative model calls; the best action found so far is always returned.
      */
     action apply(const state &s) override {
-        reference_time = s.t;
-        tmp_dnode root(s);
-        build_tree(root);
-        update_eh(&root);
-        return recommended_action(root);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        unsigned first_call = nb_calls;
+        uint64_t seed = rand();
+        for(unsigned k=0; k<nb_search_threads; ++k) {
+            get_search_thread(k)->set_root(s);
+            get_search_thread(k)->deadline = start + std::chrono::microseconds(time_limit);
+            get_search_thread(k)->rng = xoshiro_rng(seed,k);
+        }
+        parallel_run(nb_search_threads,[this](unsigned k) {
+            get_search_thread(k)->build_tree();
+        });
+        for(auto &w : workers) {
+            merge_root_statistics(w->tree);
+            nb_calls += w->nb_calls;
+            w->nb_calls = 0;
+        }
+        update_eh(0);
+        action a = recommended_action(0);
+        last_decision.duration = std::chrono::duration<double,std::micro>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+        last_decision.nb_iterations = 0;
+        last_decision.peak_tree_bytes = 0;
+        for(unsigned k=0; k<nb_search_threads; ++k) {
+            last_decision.nb_iterations += get_search_thread(k)->nb_iterations;
+            last_decision.peak_tree_bytes += get_search_thread(k)->peak_tree_bytes;
+        }
+        last_decision.nb_calls = nb_calls - first_call;
+        return a;
+    }
+
+    decision_statistics get_decision_statistics() const override {
+        return last_decision;
     }
 
     /**
@@ -2,35 +2,55 @@
 #define STATE_HPP_
 
 #include <exceptions.hpp>
-#include <map_node.hpp>
+#include <map_graph.hpp>
 #include <utils.hpp>
 
 class state {
 public:
     double t; ///< time
-    map_node * nd_ptr; ///< location in the graph
+    const map_node * nd_ptr; ///< location in the graph
 
     state() : t(0.) {}
 
-    state(double _t, map_node * _nd_ptr) : t(_t), nd_ptr(_nd_ptr) {}
+    state(double _t, const map_node * _nd_ptr) : t(_t), nd_ptr(_nd_ptr) {}
 
     std::string get_name() const {
         return nd_ptr->name;
     }
 
     unsigned get_nb_edges() const {
-        return nd_ptr->edges.size();
+        return nd_ptr->graph_ptr->get_nb_edges(nd_ptr->id);
     }
 
     /**
      * @brief Get pointer to successor
      *
      * Get a pointer to the successor designated by the given indice.
-     * @param {unsigned} indice; indice of the successor in node->edges
+     * @param {unsigned} indice; indice of the edge amongst the outgoing edges of the node
      * @return Return a map_node pointer.
      */
-    map_node * get_ptr_to_successor(unsigned indice) const {
-        return nd_ptr->edges.at(indice);
+    const map_node * get_ptr_to_successor(unsigned indice) const {
+        return nd_ptr->graph_ptr->get_successor(nd_ptr->id,indice);
+    }
+
+    /**
+     * @brief Get direction
+     *
+     * Get the name of the node the input action leads to.
+     * Names are only resolved for printing and saving purposes.
+     */
+    std::string get_direction(const action &a) const {
+        return get_ptr_to_successor(a.indice)->name;
+    }
+
+    /**
+     * @brief Get number of actions
+     *
+     * The available actions are the indices 0 to get_nb_actions()-1.
+     * A dead end has a single action, which is illegal since there is no edge.
+     */
+    unsigned get_nb_actions() const {
+        return std::max(get_nb_edges(),1u);
     }
 
     /**
@@ -40,17 +60,12 @@ public:
      * @return Return the vector of available actions.
      */
     std::vector<action> get_action_space() const {
-        if(get_nb_edges() > 0) {
-            std::vector<action> v;
-            for(auto &dest_nd_ptr : nd_ptr->edges) {
-                v.emplace_back(dest_nd_ptr->name);
-            }
-            return v;
-        } else {
-            std::vector<action> v{get_name()};
-            return v;
-            //throw no_action_exception();
+        std::vector<action> v;
+        v.reserve(get_nb_actions());
+        for(unsigned k=0; k<get_nb_actions(); ++k) {
+            v.emplace_back(k);
         }
+        return v;
     }
 
     bool is_equal_to(const state &s) const {
@@ -63,7 +78,6 @@ public:
         std::cout << "time: " << t << "; ";
         std::cout << "nbedges: " << get_nb_edges() << "; ";
         std::cout << "goal: " << nd_ptr->is_goal << "\n";
-        assert(get_nb_edges() == nd_ptr->edges_costs.size());
     }
 };
 
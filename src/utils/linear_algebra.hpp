@@ -62,6 +62,23 @@ Eigen::VectorXd polynomial_regression(
 	return a.jacobiSvd(Eigen::ComputeThinU|Eigen::ComputeThinV).solve(b); // solve
 }
 
+/**
+ * @brief Solve the normal equations of a regression
+ *
+ * Solve a symmetric positive semi-definite linear problem, with one column of the right
+ * hand side per problem, by a LDLT decomposition; fall back to a SVD when the matrix is
+ * singular, e.g. with fewer samples than coefficients and no regularization, or too badly
+ * conditioned for the decomposition to be accurate.
+ */
+Eigen::MatrixXd solve_normal_equations(const Eigen::MatrixXd &a, const Eigen::MatrixXd &b) {
+    Eigen::LDLT<Eigen::MatrixXd> ldlt(a);
+    if(ldlt.info() == Eigen::Success && ldlt.isPositive()
+        && ldlt.rcond() > std::sqrt(Eigen::NumTraits<double>::epsilon())) {
+        return ldlt.solve(b);
+    }
+	return a.jacobiSvd(Eigen::ComputeThinU|Eigen::ComputeThinV).solve(b);
+}
+
 /**
  * @brief Compute a prediction of a quadratic regression at the given point
  */
@@ -0,0 +1,54 @@
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <exceptions.hpp>
+
+/**
+ * @brief Memory-mapped file class
+ *
+ * Read-only mapping of a whole file, unmapped at destruction.
+ */
+class mapped_file {
+public:
+    const char * data; ///< First byte of the file
+    size_t size; ///< Size of the file in bytes
+
+    /**
+     * @brief Constructor
+     *
+     * Map the file at the given path.
+     * @throw duration_matrix_file_exception if the file can not be opened or mapped.
+     */
+    mapped_file(const std::string &path) : data(nullptr), size(0) {
+        int fd = open(path.c_str(),O_RDONLY);
+        if(fd < 0) {
+            throw duration_matrix_file_exception();
+        }
+        struct stat sb;
+        if(fstat(fd,&sb) != 0 || sb.st_size == 0) {
+            close(fd);
+            throw duration_matrix_file_exception();
+        }
+        size = sb.st_size;
+        void * ptr = mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fd,0);
+        close(fd);
+        if(ptr == MAP_FAILED) {
+            throw duration_matrix_file_exception();
+        }
+        data = static_cast<const char *>(ptr);
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator=(const mapped_file &) = delete;
+
+    ~mapped_file() {
+        munmap(const_cast<char *>(data),size);
+    }
+};
+
+#endif // MAPPED_FILE_HPP_
@@ -0,0 +1,99 @@
+#ifndef NUMBER_PARSING_HPP_
+#define NUMBER_PARSING_HPP_
+
+#include <cstdint>
+#include <cstdlib>
+
+constexpr double POWERS_OF_TEN[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * @brief Parse double
+ *
+ * Locale-free parsing of the decimal number written in [first, last); surrounding spaces
+ * are ignored.
+ * Numbers with at most 15 significant digits and a decimal exponent within [-22, 22], such
+ * as the ones written by std::to_string, are converted exactly with a single multiplication
+ * or division.
+ * The other ones (e.g. 'inf' or too many digits) fall back to std::strtod.
+ * @param {const char *} first; first character
+ * @param {const char *} last; past-the-end character
+ * @param {double &} value; parsed value
+ * @return Return true if the whole range is a valid number.
+ */
+inline bool parse_double(const char * first, const char * last, double &value) {
+    while(first < last && *first == ' ') {
+        ++first;
+    }
+    while(last > first && *(last - 1) == ' ') {
+        --last;
+    }
+    const char * p = first;
+    bool is_negative = false;
+    if(p < last && (*p == '-' || *p == '+')) {
+        is_negative = (*p == '-');
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int nb_digits = 0; // significant digits stored in the mantissa
+    int exponent = 0;
+    bool is_exact = true;
+    bool has_digits = false;
+    for(; p < last && *p >= '0' && *p <= '9'; ++p) {
+        has_digits = true;
+        if(nb_digits < 19) {
+            mantissa = 10 * mantissa + (*p - '0');
+            nb_digits += (mantissa > 0);
+        } else {
+            ++exponent;
+            is_exact = false;
+        }
+    }
+    if(p < last && *p == '.') {
+        for(++p; p < last && *p >= '0' && *p <= '9'; ++p) {
+            has_digits = true;
+            if(nb_digits < 19) {
+                mantissa = 10 * mantissa + (*p - '0');
+                nb_digits += (mantissa > 0);
+                --exponent;
+            } else if(*p != '0') {
+                is_exact = false;
+            }
+        }
+    }
+    if(has_digits && p < last && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool is_exponent_negative = false;
+        if(p < last && (*p == '-' || *p == '+')) {
+            is_exponent_negative = (*p == '-');
+            ++p;
+        }
+        int e = 0;
+        bool has_exponent_digits = false;
+        for(; p < last && *p >= '0' && *p <= '9'; ++p) {
+            has_exponent_digits = true;
+            if(e < 10000) {
+                e = 10 * e + (*p - '0');
+            }
+        }
+        has_digits = has_exponent_digits;
+        exponent += is_exponent_negative ? -e : e;
+    }
+    if(has_digits && p == last && is_exact && nb_digits <= 15 && exponent >= -22 && exponent <= 22) {
+        value = (double) mantissa;
+        value = (exponent < 0) ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+        value = is_negative ? -value : value;
+        return true;
+    }
+    if(first == last) {
+        return false;
+    }
+    std::string token(first,last);
+    char * end = nullptr;
+    value = std::strtod(token.c_str(),&end);
+    return end == token.c_str() + token.size();
+}
+
+#endif // NUMBER_PARSING_HPP_
@@ -0,0 +1,57 @@
+#ifndef PARALLEL_HPP_
+#define PARALLEL_HPP_
+
+#include <exception>
+#include <thread>
+
+/**
+ * @brief Get number of threads
+ *
+ * @param {unsigned} nb_threads; requested number of threads, 0 for the number of hardware
+ * threads
+ * @return Return the number of threads to use, at least 1.
+ */
+inline unsigned get_nb_threads(unsigned nb_threads) {
+    if(nb_threads == 0) {
+        nb_threads = std::thread::hardware_concurrency();
+    }
+    return (nb_threads == 0) ? 1 : nb_threads;
+}
+
+/**
+ * @brief Parallel run
+ *
+ * Run f(0), ..., f(nb_tasks-1) concurrently, each task on its own thread, the first one on
+ * the calling thread.
+ * Template method.
+ * @note The first exception thrown by a task is rethrown once every task is over.
+ */
+template <class F>
+void parallel_run(unsigned nb_tasks, const F &f) {
+    std::vector<std::exception_ptr> errors(nb_tasks);
+    auto task = [&f,&errors](unsigned i) {
+        try {
+            f(i);
+        }
+        catch(...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for(unsigned i=1; i<nb_tasks; ++i) {
+        threads.emplace_back(task,i);
+    }
+    if(nb_tasks > 0) {
+        task(0);
+    }
+    for(auto &th : threads) {
+        th.join();
+    }
+    for(auto &e : errors) {
+        if(e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+#endif // PARALLEL_HPP_
@@ -0,0 +1,125 @@
+#ifndef RNG_HPP_
+#define RNG_HPP_
+
+#include <cstdint>
+
+/**
+ * @brief Mix 64 bits
+ *
+ * SplitMix64 finalizer: bijective scrambling of a 64-bit integer.
+ */
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Counter-based random number generator
+ *
+ * The i-th number of the stream (seed, stream) is a hash of the seed, the stream and i.
+ * Streams with different indices are independent and each one can be regenerated on its
+ * own, whatever the order in which streams are used or the thread using them.
+ * Satisfies the UniformRandomBitGenerator requirements.
+ */
+class counter_rng {
+public:
+    typedef uint64_t result_type;
+
+    uint64_t key; ///< Hash of the seed and of the stream indice
+    uint64_t counter; ///< Number of generated numbers
+
+    counter_rng(uint64_t seed, uint64_t stream) :
+        key(mix64(mix64(seed) ^ stream)),
+        counter(0)
+    {}
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return UINT64_MAX;
+    }
+
+    result_type operator()() {
+        return mix64(key + 0x9e3779b97f4a7c15ULL * ++counter);
+    }
+};
+
+/**
+ * @brief Xoshiro256** random number generator
+ *
+ * Fast generator with a 256-bit state, for the inner loops of the search.
+ * The state of the stream (seed, stream) is made of the first numbers of the corresponding
+ * counter-based stream, so that streams are independent and reproducible as well.
+ * Satisfies the UniformRandomBitGenerator requirements.
+ */
+class xoshiro_rng {
+public:
+    typedef uint64_t result_type;
+
+    uint64_t st[4]; ///< State
+
+    xoshiro_rng(uint64_t seed, uint64_t stream) {
+        counter_rng seeder(seed,stream);
+        for(unsigned i=0; i<4; ++i) {
+            st[i] = seeder();
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return UINT64_MAX;
+    }
+
+    result_type operator()() {
+        uint64_t result = rotl(st[1] * 5,7) * 9;
+        uint64_t t = st[1] << 17;
+        st[2] ^= st[0];
+        st[3] ^= st[1];
+        st[1] ^= st[2];
+        st[0] ^= st[3];
+        st[2] ^= t;
+        st[3] = rotl(st[3],45);
+        return result;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+/**
+ * @brief Uniformly distributed double
+ *
+ * Generate a uniformly distributed double in [double_min, double_max) with the given
+ * generator, using its 53 high bits.
+ * Template method.
+ * @return Return the sample.
+ */
+template <class G>
+inline double uniform_double(G &generator, double double_min, double double_max) {
+    double u = (double) (generator() >> 11) * (1. / 9007199254740992.);
+    return double_min + u * (double_max - double_min);
+}
+
+/**
+ * @brief Uniformly distributed integer
+ *
+ * Generate a uniformly distributed integer in [int_min, int_max] with the given generator.
+ * Template method.
+ * @return Return the sample.
+ */
+template <class G>
+inline int uniform_integer(G &generator, int int_min, int int_max) {
+    uint64_t range = (uint64_t) ((int64_t) int_max - (int64_t) int_min) + 1;
+    return (int) ((int64_t) int_min + (int64_t) (((generator() >> 32) * range) >> 32));
+}
+
+#endif // RNG_HPP_
@@ -0,0 +1,87 @@
+#ifndef RUNNING_STATISTICS_HPP_
+#define RUNNING_STATISTICS_HPP_
+
+/**
+ * @brief Running statistics
+ *
+ * Count, mean and variance of a stream of values, updated in constant time and memory
+ * with Welford's method.
+ * The mean is the running sum divided by the count, hence it is the same as the mean of
+ * the values accumulated in order.
+ * The values themselves are only kept if KEEP_SAMPLED_RETURNS is defined, for debugging.
+ */
+class running_statistics {
+public:
+    unsigned count; ///< Number of values
+    double sum; ///< Sum of the values
+    double m2; ///< Sum of the squared deviations from the mean
+#ifdef KEEP_SAMPLED_RETURNS
+    std::vector<double> values; ///< Values, in order of arrival
+#endif
+
+    running_statistics() :
+        count(0),
+        sum(0.),
+        m2(0.)
+    {}
+
+    /**
+     * @brief Add
+     *
+     * Add a new value to the statistics.
+     */
+    void add(double x) {
+        double delta = x - get_mean();
+        ++count;
+        sum += x;
+        m2 += delta * (x - get_mean());
+#ifdef KEEP_SAMPLED_RETURNS
+        values.push_back(x);
+#endif
+    }
+
+    /**
+     * @brief Merge
+     *
+     * Add the values of other statistics, as if they were added one by one.
+     * The variance is combined with Chan et al.'s pairwise formula.
+     */
+    void merge(const running_statistics &other) {
+        if(other.count == 0) {
+            return;
+        }
+        double delta = other.get_mean() - get_mean();
+        double n = (double) count;
+        double n_other = (double) other.count;
+        m2 += other.m2 + delta * delta * n * n_other / (n + n_other);
+        count += other.count;
+        sum += other.sum;
+#ifdef KEEP_SAMPLED_RETURNS
+        values.insert(values.end(),other.values.begin(),other.values.end());
+#endif
+    }
+
+    unsigned get_count() const {
+        return count;
+    }
+
+    /**
+     * @brief Get mean
+     *
+     * @return Return the mean of the values, 0 if there is none.
+     */
+    double get_mean() const {
+        return (count == 0) ? 0. : sum / ((double) count);
+    }
+
+    /**
+     * @brief Get variance
+     *
+     * @return Return the unbiased variance of the values, 0 if there are less than two.
+     */
+    double get_variance() const {
+        return (count < 2) ? 0. : m2 / ((double) (count - 1));
+    }
+};
+
+#endif // RUNNING_STATISTICS_HPP_
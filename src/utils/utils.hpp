@@ -1,6 +1,8 @@
 #ifndef UTILS_HPP_
 #define UTILS_HPP_
 
+#include <rng.hpp>
+
 constexpr double COMPARISON_THRESHOLD = 1e-10;
 
 /**
@@ -97,11 +99,11 @@ inline void shuffle(std::vector<T> &v) {
  *
  * Pick a random indice of the input vector. You should initialize a random seed when
  * executing your program. Template method.
- * @param {const std::vector<T> &} v; input vector
+ * @param {const C &} v; input vector, or any container with a size method
  * @return Return a random indice.
  */
-template <class T>
-inline unsigned rand_indice(const std::vector<T> &v) {
+template <class C>
+inline unsigned rand_indice(const C &v) {
     assert(v.size() != 0);
     return rand() % v.size();
 }